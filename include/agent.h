@@ -0,0 +1,95 @@
+#ifndef AGENT_H
+#define AGENT_H
+
+#include "core.h"
+#include "level.h"
+#include "coord.h"
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+/********************************** AGENTENV ***********************************/
+// Lets a controller, like a bot being trained, play one game directly.
+//
+// reset(seed) starts a new game and step(action) runs one tick with that
+// action as the input, returning the points it scored and whether the game is
+// over. The tick runs the same phases and resets as Game::game_loop, with no
+// backend: nothing is drawn, nothing is read from the terminal, and the reset
+// animations are skipped. Once a game is over step() does nothing until the
+// next reset().
+//
+// observation() is a view of tile planes the env keeps up to date itself, one
+// byte per cell and plane, each plane row major:
+//  -walls: 1 for a border, 2 for a wall only ghosts can pass up through
+//  -points, power_ups: 1 where one is still on the board
+//  -pacman: 1 where pacman is
+//  -blinky, pinky, clyde, inky: 1 + the GhostState of a ghost of that kind where
+//   one is. Where ghosts of a kind share a cell the last one in the roster shows
+//
+// The planes are written once on reset() and after that only the cells that
+// change are rewritten, so a step never allocates or copies the board. The
+// view stays valid, and keeps showing the current state, until the env is
+// destroyed.
+/********************************************************************************/
+enum class Action {none, up, down, left, right};
+
+enum class ObservationPlane {walls, points, power_ups, pacman, blinky, pinky, clyde, inky};
+
+constexpr int OBSERVATION_PLANES {8};
+
+struct AgentStep
+{
+  int reward;       //points scored by the step
+  bool done;        //the game is over
+};
+
+struct Observation
+{
+  const std::uint8_t* planes;     //OBSERVATION_PLANES planes of width * height cells
+  int width;
+  int height;
+
+  const std::uint8_t* plane(ObservationPlane p) const
+  {
+    return planes + static_cast<int>(p) * width * height;
+  }
+
+  std::uint8_t at(ObservationPlane p, Coord coord) const
+  {
+    return plane(p)[coord.y * width + coord.x];
+  }
+};
+
+class AgentEnv
+{
+  public:
+    explicit AgentEnv(SharedLevel level, std::uint64_t seed = 0);
+
+    void reset(std::uint64_t seed);
+    AgentStep step(Action action);
+    Observation observation() const;
+
+    bool done() const;
+    long steps() const;           //steps since the last reset
+    const GameCore& core() const;
+
+  private:
+    SharedLevel m_level;
+    std::optional<GameCore> m_core;
+    bool m_done {false};
+    long m_steps {0};
+
+    std::vector<std::uint8_t> m_planes;
+    std::vector<Coord> m_actor_cells;   //cell each actor was last drawn at, pacman then the ghosts
+
+    std::uint8_t* plane(ObservationPlane p);
+    bool in_bounds(Coord coord) const;
+
+    void fill_maze_planes();
+    void fill_scoring_planes();
+    void clear_cell(ObservationPlane p, Coord coord);
+    void update_actor_planes();
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <string>
+
+class GameCore;   //forward declarations from core.h and game.h
+class Game;
+
+/*********************************** BACKEND ***********************************/
+// The backend is how a Game shows itself and gets its input.
+//
+// Game only talks to a backend, so the same game loop runs on a terminal, or with
+// no terminal at all. A backend can:
+//  -attach to a core, so it knows which pieces to draw, and again whenever the
+//   core changes maze, since the ghosts may have changed
+//  -get user input (blocking and non_blocking modes)
+//  -draw a whole frame of the game and its stats
+//  -show a message
+//  -pause between animation frames
+//  -look at the game after each tick (does nothing unless a backend needs it)
+/********************************************************************************/
+
+enum class InputMode {non_block, block};
+
+class Backend
+{
+  public:
+    virtual ~Backend() = default;
+
+    virtual void attach(GameCore& core) = 0;
+    virtual int get_input(InputMode input_mode) = 0;
+    virtual void draw_frame(const Game& game) = 0;
+    virtual void show_message(const std::string& text) = 0;
+    virtual void pause(int n_milliseconds) = 0;
+    virtual void end_tick(const Game& game);
+};
+
+/********************************* NULLBACKEND *********************************/
+// A backend with no terminal, used to run the game headless.
+//
+// It draws nothing and never pauses. Non blocking input is always NO_INPUT and
+// blocking input (the start and play again prompts) is always PLAY.
+/********************************************************************************/
+
+class NullBackend : public Backend
+{
+  public:
+    void attach(GameCore& core) override;
+    int get_input(InputMode input_mode) override;
+    void draw_frame(const Game& game) override;
+    void show_message(const std::string& text) override;
+    void pause(int n_milliseconds) override;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "core.h"
+#include "pieces.h"
+#include "ghosts.h"
+#include "level.h"
+#include "nav.h"
+#include "junction.h"
+#include "grid.h"
+#include "rng.h"
+
+#include <vector>
+#include <cstdint>
+
+/******************************** BATCHENGINE *********************************/
+// Steps many games of the same level in lockstep, for AI experiments.
+//
+// Instead of a GameCore of pieces per game, the state of every game is stored
+// as structure of arrays: one contiguous array per field, indexed by game.
+// Ghost fields have one array per ghost of the levels roster, in its order.
+// The points and power ups still on the board are bitsets, one run of words per game.
+//
+// step() takes one input per game and advances every game by one tick. It runs
+// the same rules as Game::game_loop with a backend that always plays again:
+// a game that ends starts over, a cleared level moves to the next one. Each
+// phase is a loop over all the games, and the ghosts move choice is worked out
+// as a branch free min over the four candidate moves so the compiler can
+// vectorize it. Ghost targets are picked by the same policies GameCore uses,
+// with a loop built for each kinds policy.
+//
+// state_hash(game) hashes a game the same way GameCore::state_hash does, so a
+// batch game can be checked tick by tick against a GameCore with the same seed.
+/********************************************************************************/
+class BatchEngine
+{
+  public:
+    BatchEngine(SharedLevel level, const std::vector<std::uint64_t>& seeds);
+
+    int size() const;                     //number of games
+    long ticks() const;                   //ticks stepped so far
+
+    void step(const int* inputs);         //one input per game
+
+    //per game getters
+    std::uint32_t state_hash(int game) const;
+    int score(int game) const;
+    int lives(int game) const;
+    int level(int game) const;
+    int games_played(int game) const;
+    int points_remaining(int game) const;
+    Coord pacman_location(int game) const;
+    std::uint64_t seed(int game) const;
+    int ghost_count() const;              //ghosts in each game
+
+  private:
+    //level data shared by every game
+    SharedLevel m_maze;                   //keeps the level alive, the views below point into it
+    TileGrid m_grid;
+    NavMap m_nav;
+    const JunctionGraph* m_junctions;
+    TileBitsetView m_start_points;
+    TileBitsetView m_start_power_ups;
+    int m_point_count;
+    int m_power_up_count;
+    Coord m_pacman_home;
+    int m_ghosts;                         //ghosts in each game
+    std::vector<Coord> m_ghost_home;      //per ghost
+    std::vector<Coord> m_ghost_scatter;
+    GhostRange m_kinds[GHOST_KINDS];      //where each kinds ghosts are in the roster
+    int m_partner;                        //the ghost inkys target is offset by, -1 if none
+    Coord m_left_warp;
+    Coord m_right_warp;
+    int m_words;                          //bitset words per game
+
+    int m_size;
+    long m_ticks {0};
+
+    //pacman
+    std::vector<int> m_pac_x;
+    std::vector<int> m_pac_y;
+    std::vector<std::uint8_t> m_pac_momentum;
+    std::vector<int> m_pac_lives;
+    std::vector<int> m_pac_points;
+    std::vector<std::uint8_t> m_pac_eaten;
+
+    //ghosts, one array per ghost
+    std::vector<std::vector<int>> m_ghost_x;
+    std::vector<std::vector<int>> m_ghost_y;
+    std::vector<std::vector<std::uint8_t>> m_ghost_momentum;
+    std::vector<std::vector<std::uint8_t>> m_ghost_state;
+    std::vector<std::vector<std::uint8_t>> m_ghost_eaten;
+
+    //points and power ups
+    std::vector<std::uint64_t> m_points;        //m_words per game
+    std::vector<std::uint64_t> m_power_ups;
+    std::vector<int> m_points_remaining;
+    std::vector<int> m_power_ups_remaining;
+    std::vector<std::uint8_t> m_points_scored;
+    std::vector<std::uint8_t> m_power_up_scored;
+    std::vector<std::uint8_t> m_power_up_active;
+
+    //timers and game states
+    std::vector<int> m_power_up_timer;
+    std::vector<int> m_pursuit_timer;
+    std::vector<int> m_blink_timer;
+    std::vector<std::uint8_t> m_pursuit_state;
+    std::vector<int> m_level;
+    std::vector<int> m_games_played;
+    std::vector<Rng> m_rngs;
+
+    //scratch for the ghost phase, one entry per game
+    std::vector<std::uint8_t> m_moving;
+    std::vector<int> m_target_x;
+    std::vector<int> m_target_y;
+    std::vector<std::uint8_t> m_valid[4];         //per candidate move, right down left up
+    std::vector<int> m_distance[4];
+    std::vector<std::uint8_t> m_forced;           //corridor move, if the ghost has one
+    std::vector<std::uint8_t> m_destination;
+
+    /*************** tick phases **************/
+    void pacman_phase(const int* inputs);
+    void ghost_phase();
+    void score_phase();
+    void reset_phase();
+    void end_phase();
+
+    //ghost phase steps, for one ghost across every game
+    template<typename Policy> void ghost_targets(int ghost);
+    void ghost_destinations(int ghost);
+    void move_ghosts(int ghost);
+
+    //collision checks, in the roster order GameCore uses
+    void check_pacman_eaten(int game);
+    void check_ghosts_eaten(int game);
+
+    //resets
+    void reset_positions(int game);
+    void next_level(int game);
+    void reset_game(int game);
+
+    void take_warp(int& x, int& y) const;
+    bool take_cell(std::vector<std::uint64_t>& cells, int game, int x, int y) const;
+    Coord two_infront_of_pacman(int game) const;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include "coord.h"
+
+#include <limits>
+
+/*********************************** CANVAS ***********************************/
+// Something pieces can draw their symbols onto.
+//
+// Pieces only know about the canvas, so the game logic never depends on the
+// terminal library a backend draws with.
+//
+// A canvas can show just part of a maze. Pieces with many cells only draw the
+// ones in area(), so drawing onto a small canvas costs its size, not the mazes.
+/********************************************************************************/
+class Canvas
+{
+  public:
+    virtual ~Canvas() = default;
+
+    virtual void put(Coord coord, char symbol) = 0;   //draw symbol at coord, ignored outside area()
+
+    //the cells the canvas shows, every cell from (0,0) unless a canvas says otherwise
+    virtual Rect area() const
+    {
+      return Rect{Coord{0, 0}, std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    }
+};
+
+#endif
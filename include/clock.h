@@ -0,0 +1,45 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <chrono>
+
+/********************************* TICKCLOCK **********************************/
+// A fixed timestep scheduler on the monotonic clock.
+//
+// Each tick has a deadline one period after the last one. wait() sleeps until
+// the next deadline, so the time a tick spent working is taken out of its sleep
+// and the tick rate stays exact.
+//
+// If a tick finishes after its deadline, the deadline is missed and wait()
+// returns right away so the loop can catch up. If the loop falls more than
+// max_catch_up periods behind, the missed ticks are dropped and the schedule
+// starts again from now.
+/********************************************************************************/
+class TickClock
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    TickClock(std::chrono::milliseconds period, int max_catch_up);
+
+    std::chrono::milliseconds period() const;
+    void set_period(std::chrono::milliseconds period);
+
+    void restart();           //start a fresh schedule from now, after a pause that isnt a tick
+    void wait();              //sleep until the next deadline
+
+    long missed() const;                      //deadlines missed
+    long dropped() const;                     //ticks dropped because we fell too far behind
+    std::chrono::microseconds max_late() const;  //worst time a deadline was missed by
+
+  private:
+    std::chrono::milliseconds m_period;
+    int m_max_catch_up;
+    Clock::time_point m_deadline;
+
+    long m_missed {0};
+    long m_dropped {0};
+    Clock::duration m_max_late {0};
+};
+
+#endif
@@ -3,7 +3,6 @@
 
 #include "coord.h"
 #include <string>
-#include <list>
 
 namespace Symbols
 {
@@ -23,46 +22,47 @@ namespace Symbols
   constexpr char INVISIBLE {' '};
 }
 
-// shapes and location coords are generated in config.cpp
+//the cells of a shape, relative to the pieces location, kept in static storage
+//so every piece of the same shape shares them
+struct Shape
+{
+  const Coord* cells {nullptr};
+  int size {0};
+
+  const Coord* begin() const { return cells; }
+  const Coord* end() const { return cells + size; }
+};
+
+// level specific shapes and locations are loaded into a Level, see level.h
 namespace Shapes
 {
-  const std::list<Coord> POINT { {0,0} };
-  extern const std::list<Coord> BORDER;
-  extern const std::list<Coord> INV_WALLS;
-  extern const std::list<Coord> POINTS;
-  extern const std::list<Coord> POWER_UPS;
-  extern const std::list<Coord> GHOST_HOME;
+  constexpr Coord POINT_CELLS[] { {0,0} };
+  constexpr Shape POINT {POINT_CELLS, 1};
+  constexpr Shape NONE {};      //for pieces that draw their cells some other way
 }
 
 namespace Locations
 {
   const Coord TOP_LEFT {0,0};
-  extern const Coord PACMAN_START;
-  extern const Coord PINKY_START;
-  extern const Coord PINKY_SCATTER;
-  extern const Coord BLINKY_START;
-  extern const Coord BLINKY_SCATTER;
-  extern const Coord CLYDE_START;
-  extern const Coord CLYDE_SCATTER;
-  extern const Coord INKY_START;
-  extern const Coord INKY_SCATTER;
-  extern const Coord LEFT_WARP;
-  extern const Coord RIGHT_WARP;
 }
 
 //Dimensions and positions of our windows
 namespace Dimensions
 {
-  constexpr int GAME_SCR_H {25};
-  constexpr int GAME_SCR_W {60};
+  //the game window is the size of the maze, or GAME_SCR_MIN_H x GAME_SCR_MIN_W for a smaller one,
+  //but no bigger than the terminal has room for above the stats. Over a larger maze it scrolls
+  constexpr int GAME_SCR_MIN_H {25};
+  constexpr int GAME_SCR_MIN_W {60};
   const Coord GAME_SCR_COORD {0,0};
 
-  constexpr int STAT_SCR_H {5};
-  constexpr int STAT_SCR_W {30};
-  const Coord STAT_SCR_COORD {(GAME_SCR_COORD.y + GAME_SCR_H), 0};
+#ifdef PACMAN_PROFILE
+  constexpr int STAT_SCR_H {10};    //room for the profile overlay
+#else
+  constexpr int STAT_SCR_H {6};
+#endif
+  constexpr int STAT_SCR_W {30};    //placed right below the game window
 
-  constexpr int MSG_SCR_H {9};
-  constexpr int MSG_SCR_W {GAME_SCR_W};
+  constexpr int MSG_SCR_H {9};      //as wide as the game window, over it
   const Coord MSG_SCR_COORD = {5,0};
 }
 
@@ -74,14 +74,26 @@ namespace Inputs
   constexpr int DOWN {'s'};
   constexpr int LEFT {'a'};
   constexpr int RIGHT {'d'};
+  constexpr int FASTER {'+'};     //shorten the tick period
+  constexpr int SLOWER {'-'};     //lengthen the tick period
+  constexpr int PROFILE {'o'};    //toggle the profile overlay, profiled builds only
   constexpr int NO_INPUT {'\0'};
 }
 
 namespace Pause
 {
-  constexpr int SHORT {190};
+  constexpr int SHORT {190};      //default tick period
   constexpr int MEDIUM {300};
   constexpr int LONG {600};
+  constexpr int MESSAGE {3000};   //longest a message holds up the game before it goes on
+}
+
+namespace TickRate
+{
+  constexpr int MIN_MS {20};          //shortest tick period FASTER can set
+  constexpr int MAX_MS {1000};        //longest tick period SLOWER can set
+  constexpr int STEP_MS {10};         //how much FASTER and SLOWER change the period by
+  constexpr int MAX_CATCH_UP {3};     //ticks the clock can fall behind before it drops them
 }
 
 namespace GameConfig
@@ -96,6 +108,8 @@ namespace GameConfig
   constexpr int SCATTER_LENGTH {20};
   constexpr int POWER_UP_LENGTH {40};
   constexpr int POWER_UP_BLINK_LENGTH {2};
+  constexpr bool DRAW_INTERMEDIATE_FRAMES {false};    //also draw the frame between pacman and the ghosts moving
+  constexpr long HEADLESS_TICKS {1000000};            //default length of a headless run
 }
 
 namespace GameText
@@ -112,5 +126,8 @@ namespace GameText
                                 "\n\t Press p to start game"
                                 "\n\t Press Q to exit"
                                 "\n\t Thank you, for playing!"};
+
+  constexpr const char* RELOADED_MSG {"\n\tReloaded maze "};                  //followed by its number
+  constexpr const char* RELOAD_FAILED_MSG {"\n\tKept the old maze, couldn't reload maze "};    //number and error
 }
 #endif
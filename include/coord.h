@@ -17,4 +17,15 @@ Coord operator-(const Coord& l, const Coord& r);
 
 int squared_dist(const Coord& l, const Coord& r);
 
+//a block of cells, origin is its top left
+struct Rect
+{
+  Coord origin;
+  int width;
+  int height;
+};
+
+bool contains(const Rect& rect, Coord coord);
+Rect intersect(const Rect& l, const Rect& r);   //0 wide or high if they dont overlap
+
 #endif
@@ -0,0 +1,220 @@
+#ifndef CORE_H
+#define CORE_H
+
+#include "pieces.h"
+#include "ghosts.h"
+#include "grid.h"
+#include "level.h"
+#include "pack.h"
+#include "nav.h"
+#include "junction.h"
+#include "rng.h"
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+struct Metrics;   //forward declaration from metrics.h
+
+/*
+ * The game core holds all the game pieces and runs the state and movement logic
+ * of a tick. It never draws, reads input or sleeps, so it can run without a terminal
+ * and as fast as the caller steps it.
+ *
+ * A tick runs these phases in order:
+ *  -pacman_phase(input): move pacman and check for collisions
+ *  -ghost_phase(): move the ghosts and check for collisions
+ *  -score_phase(): check scores, update pacmans points and all the states
+ *  -then, if the tick ended the game, cleared the level or ate pacman, the matching reset
+ *  -end_phase(): clear the ticks flags and blink the power ups
+ *
+ * Game runs the phases itself so it can draw and animate in between them.
+ *
+ * The maze itself is a SharedLevel, never copied. A core only owns the state one
+ * game changes: the pieces, the bitsets of uneaten points and power ups, timers
+ * and the rng.
+ *
+ * The ghosts are whatever roster the level declares, kept in one vector sorted
+ * by kind. Each kinds ghosts move, in GhostKind order, through a loop built for
+ * that kinds policy in ghosts.h. Every ghost is tracked in a PieceIndex of the
+ * cells they are on, so the collision checks only look at the ghosts on pacmans
+ * cell and cost the same however many ghosts the level has.
+ *
+ * A core made from a LevelPack plays the packs mazes in turn. next_level() and
+ * reset_game() load the new maze into the same pieces and ask the pack to
+ * prefetch the maze after it. reload_maze() does the same mid level for a maze
+ * whose files were edited. A maze with another number of ghosts adds or drops
+ * ghosts, so after any of the three get actors() again.
+ */
+
+enum class PursuitState {chase, scatter};     //game alternates between chase and scatter modes
+
+//32 bit FNV-1a over the ints of a game state, so every engine hashes a state the same way
+class StateHash
+{
+  public:
+    void add(int value)
+    {
+      for(int i = 0; i < 4; i++) {
+        m_hash ^= static_cast<std::uint8_t>(value >> (i * 8));
+        m_hash *= 16777619u;
+      }
+    }
+
+    std::uint32_t value() const { return m_hash; }
+
+  private:
+    std::uint32_t m_hash {2166136261u};
+};
+
+class GameCore
+{
+  public:
+    GameCore(SharedLevel level, std::uint64_t seed);                  //plays one maze on every level
+    GameCore(std::shared_ptr<LevelPack> pack, std::uint64_t seed);    //throws LevelError
+
+    //the ghosts point at the cores index of their cells
+    GameCore(const GameCore&) = delete;
+    GameCore& operator=(const GameCore&) = delete;
+
+    //tick phases
+    void pacman_phase(int input);
+    void ghost_phase();
+    void score_phase();
+    void end_phase();
+
+    //what the tick did
+    bool game_over() const;         //pacman is out of lives
+    bool level_cleared();           //all the points were eaten
+    bool pacman_eaten();            //pacman was eaten this tick
+    bool point_scored();            //pacman ate a point this tick
+    bool power_up_scored();         //pacman ate a power up this tick
+
+    //resets
+    void reset_positions();         //send pacman and the ghosts home
+    void next_level();              //send pieces home, put the points back and go up a level
+    void reset_game();              //start a new game from level 1
+
+    //play a reloaded maze if its the one being played, restarting the level but keeping
+    //the score and lives. Returns false if the game is on another maze
+    bool reload_maze(int maze, SharedLevel level);
+
+    //getters
+    int level() const;
+    int maze_width() const;               //of the maze being played
+    int maze_height() const;
+    std::uint64_t seed() const;
+    const PacMan& pacman() const;
+    int ghost_count() const;
+    const Ghost& ghost(int n) const;      //n from 0 to ghost_count() - 1, in the levels order
+
+    //count what happens in the game into metrics, nullptr to stop counting
+    void set_metrics(Metrics* metrics);
+
+    //hash of the game state: positions, ghost states, timers, points left, score and level
+    std::uint32_t state_hash() const;
+
+    //pieces grouped for drawing and animating
+    std::vector<Piece*> actors();         //pacman and the ghosts
+    std::vector<Piece*> maze();           //borders, points and power ups
+
+  private:
+    friend class GameCoreBench;   //lets pacman-bench time the private movement methods
+
+    std::shared_ptr<LevelPack> m_pack;      //where the next levels maze comes from, if set
+
+    //the maze, shared with every other game on it, the pieces and grids below point into it
+    SharedLevel m_level;
+
+    //Game pieces
+    PacMan m_pacman;            //pacman
+
+    std::vector<Ghost> m_ghosts;              //ghosts, sorted by kind
+    GhostRange m_kinds[GHOST_KINDS] {};       //where each kinds ghosts are in m_ghosts
+    int m_partner {-1};                       //the ghost inkys target is offset by, -1 if none
+    PieceIndex m_ghost_cells;                 //the cells the ghosts are on, slots are m_ghosts indexes
+
+    Borders m_borders;           //borders
+
+    TileGrid m_grid;            //wall flags for every cell, used for all collision checks
+    NavMap m_nav;               //path distances the ghosts steer by
+    const JunctionGraph* m_junctions;   //where ghosts have a choice of moves
+
+    Points m_points;            //scoring pieces
+    PowerUps m_power_ups;
+
+    LeftWarp m_left_warp;       //warps
+    RightWarp m_right_warp;
+
+    //timers
+    int m_power_up_timer {0};         //used to set power up length
+    int m_pursuit_state_timer {0};    //used to set chase/scatter lengths
+    int m_power_up_blink_timer {0};   //used to blink powerups every n_turns
+
+    //pursuit state
+    PursuitState m_pursuit_state {PursuitState::scatter};
+
+    //current game level
+    int m_game_level {GameConfig::STARTING_LEVEL};
+
+    //every random decision draws from this
+    Rng m_rng;
+
+    Metrics* m_metrics {nullptr};     //counts eaten pieces and resets, if set
+
+    GameCore(std::shared_ptr<LevelPack> pack, SharedLevel level, std::uint64_t seed);
+
+    /*************** core methods **************/
+
+    //swap to the maze for a game level, if the pack has another one
+    void load_maze(int game_level);
+    void swap_maze(SharedLevel level);    //load a maze into the pieces
+    void load_ghosts();                   //match the ghosts to m_levels roster
+
+    //pacman move methods
+    void move_pacman(int input);
+    void pacman_keep_moving();
+
+    //ghost move methods
+    void move_ghosts();
+    template<typename Policy> void move_ghosts(GhostRange range);   //move one kinds ghosts
+    void move_ghost(Ghost* ghost, Coord target);
+    enum class Destination {go_up, go_left, go_right, go_down, stay_still, decide};
+    Destination corridor_destination(Ghost* ghost);     //the forced move in a corridor, else decide
+    Destination calc_ghost_destination(Ghost* ghost, Coord target);
+
+    //check for a warp
+    void check_for_warp(DynamicPiece* p);
+
+    //calc ghost target methods
+    Coord random_target(Ghost* ghost);
+    Coord behind_target(Ghost* ghost);
+    Coord two_infront_of_pacman();
+    ChaseView chase_view();
+    template<typename Policy> Coord ghost_target(Ghost* ghost, const ChaseView& view);
+
+    //update game states
+    void update_pursuit_state();
+    void update_ghost_state(Ghost* ghost);
+    void update_ghost_states();
+    void update_power_ups_state();
+
+    //calc pacmans score
+    void calc_pacman_score();
+
+    //check what peices were eaten
+    //the ghost on pacman that accept(ghost), with the lowest order(slot)
+    template<typename F, typename K> Ghost* ghost_on_pacman(F accept, K order);
+    bool check_pacman_eaten();
+    bool check_points_scored();
+    bool check_power_ups_scored();
+    bool check_ghosts_eaten();
+
+    //reset methods
+    void reset_piece_flags();
+
+    //blink methods
+    void blink_power_ups();
+};
+
+#endif
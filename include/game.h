@@ -1,121 +1,107 @@
 #ifndef GAME_H
 #define GAME_H
 
-#include "screen.h"
+#include "core.h"
+#include "backend.h"
 #include "pieces.h"
+#include "level.h"
+#include "pack.h"
+#include "clock.h"
+#include "config.h"
+#include "profile.h"
+#include "metrics.h"
+#include "watch.h"
 
 #include <vector>
+#include <cstdint>
+#include <string>
+#include <memory>
 
 /*
- * The game class runs the pacman game and handles all state and movement logic.
+ * The game class runs the pacman game loop.
+ *
+ * It steps a GameCore through each tick and uses a Backend to get input, draw
+ * frames and play the blink animations. With a NullBackend the same loop runs
+ * headless, with no terminal and no pauses.
+ *
+ * When throttled, ticks are paced by a TickClock. Otherwise they run back to back.
+ *
+ * In a profiled build each phase of the loop is timed by a Profiler, see profile.h.
+ * The resets phase includes the animations it plays.
+ *
+ * With a LevelWatcher, mazes reloaded from edited files are swapped in between
+ * ticks. The level starts over on the new maze with the score and lives kept,
+ * and a maze that failed to load leaves the old one playing and its error in
+ * the message window. The game waits on either message until a key is pressed,
+ * or for Pause::MESSAGE.
  */
 
-enum class PursuitState {chase, scatter};     //game alternates between chase and scatter modes
+struct GameOptions
+{
+  long max_ticks {0};               //stop after this many ticks, 0 to play until quit
+  int tick_ms {Pause::SHORT};       //tick period when throttled
+  bool throttle {true};             //pace ticks with the clock
+  std::uint64_t seed {0};           //seed for the games random decisions
+  std::string profile_csv;          //files to export tick timings to, profiled builds only
+  std::string profile_trace;
+  Metrics* metrics {nullptr};       //where to record tick timings and game counts, if anywhere
+  LevelWatcher* watcher {nullptr};  //where edited mazes come from, if anywhere
+};
 
 class Game
 {
   public:
-    Game();
-    void run();
-
-  private:
-    //Game windows
-    Screen m_scrn;              //main ncurses screen
-    GameWindow m_game_win;      //game window, where game is played
-    TextWindow m_stat_win;      //stats window, where stats are printed
-    TextWindow m_message_win;   //message window, where start and game over messages are printed
-
-    //Game pieces
-    PacMan m_pacman;            //pacman
-
-    Blinky m_blinky;            //ghosts
-    Pinky m_pinky;
-    Clyde m_clyde;
-    Inky m_inky;
-
-    Borders m_borders;           //borders
-    InvWalls m_inv_walls;
+    Game(std::shared_ptr<LevelPack> levels, Backend& backend, const GameOptions& options = GameOptions{});   //throws LevelError
 
-    Points m_points;            //scoring pieces
-    PowerUps m_power_ups;
+    void run();                       //play until quit, or until options.max_ticks ticks
 
-    LeftWarp m_left_warp;       //warps
-    RightWarp m_right_warp;
-
-    //timers
-    int m_power_up_timer {0};         //used to set power up length
-    int m_pursuit_state_timer {0};    //used to set chase/scatter lengths
-    int m_power_up_blink_timer {0};   //used to blink powerups every n_turns
+    long ticks() const;               //ticks run so far
+    int games_played() const;         //games that have ended in a game over
+    const GameCore& core() const;
+    const TickClock& clock() const;
+#ifdef PACMAN_PROFILE
+    const Profiler& profiler() const;
+#endif
 
-    //pursuit state
-    PursuitState m_pursuit_state {PursuitState::scatter};
+  private:
+    GameCore m_core;            //pieces and game logic
+    Backend& m_backend;         //input and drawing
+    GameOptions m_options;
+    TickClock m_clock;          //paces the ticks when throttled
+#ifdef PACMAN_PROFILE
+    Profiler m_profiler;        //times each phase of a tick
+#endif
 
-    //current game level
-    int m_game_level {GameConfig::STARTING_LEVEL};
+    long m_ticks {0};
+    int m_games_played {0};
 
     /*************** game methods **************/
 
     //main game loop
     void game_loop();
 
-    //pacman move methods
-    void move_pacman(int input);
-    void pacman_keep_moving();
-
-    //ghost move methods
-    void move_ghosts();
-    void move_ghost(Ghost* ghost, Coord target);
-    enum class Destination {go_up, go_left, go_right, go_down, stay_still};
-    Destination calc_ghost_destination(Ghost* ghost, Coord target);
-
-    //check for a warp
-    void check_for_warp(DynamicPiece* p);
-
-    //calc ghost target methods
-    Coord random_target(Ghost* ghost);
-    Coord behind_target(Ghost* ghost);
-    Coord blinky_target();
-    Coord pinky_target();
-    Coord two_infront_of_pacman();
-    Coord clyde_target();
-    Coord inky_target();
-
-    //update game states
-    void update_pursuit_state();
-    void update_ghost_state(Ghost* ghost);
-    void update_ghost_states();
-    void update_power_ups_state();
-
-    //calc pacmans score
-    void calc_pacman_score();
-
-    //check what peices were eaten
-    bool check_pacman_eaten();
-    bool check_points_scored();
-    bool check_power_ups_scored();
-    bool check_ghosts_eaten();
-
-    //reset methods
+    //handle the tick rate inputs
+    void change_tick_rate(int input);
+
+    //swap in the mazes the watcher reloaded, at the start of a tick, and hold
+    //the game on the reload message. Returns true if it showed one
+    bool apply_reloads();
+
+    //reset methods, with their animations
     void reset_piece_positions();
     void reset_level();
-    void reset_game();
-    void reset_piece_flags();
 
     //blink methods
     void blink_pieces(const std::vector<Piece*>& pieces, int n_times);
-    void blink_power_ups();
 
     //play again prompt
     bool play_again();
 
-    //print game stats
-    void print_stats();
+    //draw the game and stats as one frame
+    void draw_frame();
 
     //pause game execution for n milliseconds
     void pause(int n_milliseconds);
-
-    //calc scaled linear distance between two coords
-    int scaled_distance(const Coord l, const Coord r);
 };
 
 #endif
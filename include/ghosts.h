@@ -0,0 +1,113 @@
+#ifndef GHOSTS_H
+#define GHOSTS_H
+
+#include "coord.h"
+#include "level.h"
+#include "nav.h"
+
+#include <tuple>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+/******************************* GHOST POLICIES ********************************/
+// How each kind of ghost picks its target while chasing pacman. In every other
+// state all the kinds target the same way.
+//
+// GhostPolicies is a table of policy types indexed by GhostKind. A policy is a
+// struct with a static target(ghost, scatter, view), so an engine keeps its
+// ghosts sorted by kind and runs each kinds run through a loop instantiated for
+// that kinds policy, see for_each_ghost_kind(). Picking a target is then a
+// direct call the compiler can inline, with no virtual call or switch per ghost.
+//
+// To add a kind: add it to GhostKind, give it symbols in GHOST_SYMBOLS and
+// Ghost's draw symbols, and add its policy here in the same place.
+/********************************************************************************/
+
+//what the policies see of the game, taken before each kinds ghosts move
+struct ChaseView
+{
+  Coord pacman;           //pacmans location
+  Coord ahead;            //two moves in front of pacman
+  Coord partner;          //the first blinky, {0,0} if the level has none
+  NavMap nav;
+};
+
+//straight at pacman
+struct BlinkyChase
+{
+  static Coord target(Coord, Coord, const ChaseView& view) { return view.pacman; }
+};
+
+//two moves in front of pacman
+struct PinkyChase
+{
+  static Coord target(Coord, Coord, const ChaseView& view) { return view.ahead; }
+};
+
+//pacman, until it is 8 or fewer moves away, then the ghosts scatter target
+struct ClydeChase
+{
+  static Coord target(Coord ghost, Coord scatter, const ChaseView& view);
+};
+
+//in front of pacman, offset by where blinky is
+struct InkyChase
+{
+  static Coord target(Coord, Coord, const ChaseView& view) { return view.ahead - view.partner; }
+};
+
+using GhostPolicies = std::tuple<BlinkyChase, PinkyChase, ClydeChase, InkyChase>;
+
+static_assert(std::tuple_size<GhostPolicies>::value == GHOST_KINDS, "every kind of ghost needs a policy");
+
+template<GhostKind Kind>
+using GhostPolicy = std::tuple_element_t<static_cast<std::size_t>(Kind), GhostPolicies>;
+
+template<GhostKind Kind>
+using GhostKindConstant = std::integral_constant<GhostKind, Kind>;
+
+//call f(GhostKindConstant<kind>{}) for each kind, in GhostKind order
+template<typename F, std::size_t... Kinds>
+void for_each_ghost_kind(F&& f, std::index_sequence<Kinds...>)
+{
+  (f(GhostKindConstant<static_cast<GhostKind>(Kinds)>{}), ...);
+}
+
+template<typename F>
+void for_each_ghost_kind(F&& f)
+{
+  for_each_ghost_kind(std::forward<F>(f), std::make_index_sequence<GHOST_KINDS>{});
+}
+
+//the order pacman eats ghosts in when it is on several at once, as the game
+//always has: inky before clyde, unlike the roster. Ghosts of a kind go in roster order
+constexpr GhostKind GHOST_EAT_ORDER[GHOST_KINDS] {GhostKind::blinky, GhostKind::pinky, GhostKind::inky, GhostKind::clyde};
+
+constexpr int ghost_eat_rank(GhostKind kind)
+{
+  for(int rank = 0; rank < GHOST_KINDS; rank++) {
+    if(GHOST_EAT_ORDER[rank] == kind)
+      return rank;
+  }
+  return GHOST_KINDS;
+}
+
+//squared distance between two coords, with x halved since pieces move 2 left or right
+inline int scaled_distance(Coord l, Coord r)
+{
+  int x_diff = (l.x - r.x) / 2;
+  int y_diff = l.y - r.y;
+  return x_diff * x_diff + y_diff * y_diff;
+}
+
+inline Coord ClydeChase::target(Coord ghost, Coord scatter, const ChaseView& view)
+{
+  int distance = view.nav.path_distance(ghost, view.pacman);
+  if(distance < 0)    //no distance table for this maze, go by a straight line
+    distance = scaled_distance(ghost, view.pacman);
+
+  return distance > 8 ? view.pacman : scatter;
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "coord.h"
+
+#include <vector>
+#include <cstdint>
+
+/*********************************** TILE ************************************/
+// Flags stored in each cell of a TileGrid. A cell can hold more than one flag.
+/********************************************************************************/
+namespace Tile
+{
+  constexpr std::uint8_t EMPTY {0};
+  constexpr std::uint8_t BORDER {1 << 0};
+  constexpr std::uint8_t INV_WALL {1 << 1};
+  constexpr std::uint8_t POINT {1 << 2};
+  constexpr std::uint8_t POWER_UP {1 << 3};
+  constexpr std::uint8_t GHOST_HOME {1 << 4};
+}
+
+/********************************* TILEGRID **********************************/
+// A level wide grid holding a flag byte for every cell.
+//
+// The grid is a read only view over tiles owned by a Level, so checking a coord
+// for a collision is a single array index and copying a grid is cheap.
+//
+// Coords outside of the grid are always Tile::EMPTY.
+/********************************************************************************/
+class TileGrid
+{
+  public:
+    TileGrid() = default;
+    TileGrid(int width, int height, const std::uint8_t* tiles);
+
+    int width() const;
+    int height() const;
+
+    bool in_bounds(Coord coord) const;
+    std::uint8_t at(Coord coord) const;   //returns the flags at coord
+
+    bool is_border(Coord coord) const;      //is coord a border
+    bool is_inv_wall(Coord coord) const;    //is coord an invisible wall
+    bool is_wall(Coord coord) const;        //is coord a border or invisible wall
+
+    //call f(coord) for every cell that has any of the flags set, in row major order
+    template<typename F>
+    void for_each(std::uint8_t flags, F f) const
+    {
+      for(int y = 0; y < m_height; y++) {
+        for(int x = 0; x < m_width; x++) {
+          if(m_tiles[y * m_width + x] & flags)
+            f(Coord{x, y});
+        }
+      }
+    }
+
+    //the same, only for the cells in area
+    template<typename F>
+    void for_each(std::uint8_t flags, Rect area, F f) const
+    {
+      Rect cells = intersect(area, Rect{Coord{0, 0}, m_width, m_height});
+      for(int y = cells.origin.y; y < cells.origin.y + cells.height; y++) {
+        const std::uint8_t* row = m_tiles + y * m_width;
+        for(int x = cells.origin.x; x < cells.origin.x + cells.width; x++) {
+          if(row[x] & flags)
+            f(Coord{x, y});
+        }
+      }
+    }
+
+  private:
+    int m_width {0};
+    int m_height {0};
+    const std::uint8_t* m_tiles {nullptr};    //row major, m_width * m_height flags
+};
+
+/******************************** TILEBITSET *********************************/
+// A grid of single bits, one per cell, packed into 64 bit words.
+//
+// Used by scoring pieces to track which of their cells are still on the board.
+// A TileBitsetView is a read only bitset owned by someone else (like a Level),
+// copy_from() restores a whole board from one with a single memcpy.
+//
+// Coords outside of the bitset are never set.
+/********************************************************************************/
+struct TileBitsetView
+{
+  int width;
+  int height;
+  const std::uint64_t* words;
+};
+
+//number of 64 bit words needed to hold one bit per cell, 64 bit so any header dimensions fit
+constexpr std::int64_t bitset_words(std::int64_t width, std::int64_t height) { return (width * height + 63) / 64; }
+
+class TileBitset
+{
+  public:
+    TileBitset(int width = 0, int height = 0);
+    explicit TileBitset(TileBitsetView view);   //copy of the view
+
+    int width() const;
+    int height() const;
+
+    bool in_bounds(Coord coord) const;
+    bool test(Coord coord) const;
+    void set(Coord coord);
+    void clear(Coord coord);
+
+    int count() const;                        //number of set bits
+    void copy_from(TileBitsetView view);      //view must have the same dimensions
+    TileBitsetView view() const;
+
+    //call f(coord) for every set bit, in row major order
+    template<typename F>
+    void for_each(F f) const
+    {
+      for(std::size_t w = 0; w < m_words.size(); w++) {
+        std::uint64_t word = m_words[w];
+        while(word) {
+          int index = static_cast<int>(w * 64) + __builtin_ctzll(word);
+          f(Coord{index % m_width, index / m_width});
+          word &= word - 1;   //clear lowest set bit
+        }
+      }
+    }
+
+    //the same, only for the bits in area, a row at a time
+    template<typename F>
+    void for_each(Rect area, F f) const
+    {
+      Rect cells = intersect(area, Rect{Coord{0, 0}, m_width, m_height});
+      for(int y = cells.origin.y; y < cells.origin.y + cells.height; y++) {
+        int first = y * m_width + cells.origin.x;
+        int last = first + cells.width;         //one past the rows last bit
+        for(int w = first / 64; w * 64 < last; w++) {
+          std::uint64_t word = m_words[w];
+          if(w * 64 < first)
+            word &= ~std::uint64_t{0} << (first - w * 64);
+          if((w + 1) * 64 > last)
+            word &= ~std::uint64_t{0} >> ((w + 1) * 64 - last);
+          while(word) {
+            int index = w * 64 + __builtin_ctzll(word);
+            f(Coord{index - y * m_width, y});
+            word &= word - 1;
+          }
+        }
+      }
+    }
+
+  private:
+    int m_width;
+    int m_height;
+    std::vector<std::uint64_t> m_words;
+};
+
+/******************************** PIECEINDEX *********************************/
+// Which dynamic pieces are on each cell of a level, so a collision check looks
+// at the pieces on one cell instead of at every piece in the game.
+//
+// A piece is added once and gets a slot back, slots count up from 0. After that
+// the piece reports every move itself, see DynamicPiece::track(). Each cell holds
+// the head of a list threaded through the slots, so a move unlinks and relinks
+// one slot and never allocates. Pieces off the grid share one more list.
+//
+// Only a pieces location is indexed, so it is meant for one cell pieces.
+/********************************************************************************/
+class PieceIndex
+{
+  public:
+    PieceIndex(int width = 0, int height = 0);
+
+    void clear(int width, int height);    //drop every piece and resize for a maze
+
+    int add(Coord location);              //returns the new pieces slot
+    void moved(int slot, Coord location);
+    int size() const;                     //number of pieces
+
+    //call f(slot) for every piece at coord, most recently moved first
+    template<typename F>
+    void for_each_at(Coord coord, F f) const
+    {
+      for(int slot = m_heads[list(coord)]; slot >= 0; slot = m_next[slot]) {
+        if(m_locations[slot] == coord)    //the off grid list holds any coord
+          f(slot);
+      }
+    }
+
+  private:
+    int m_width;
+    int m_height;
+    std::vector<int> m_heads;         //first slot on each cell then off the grid, -1 if none
+    std::vector<int> m_next;          //next slot in the same list, -1 at the end
+    std::vector<int> m_prev;          //previous slot in the same list, -1 at the head
+    std::vector<Coord> m_locations;
+
+    int list(Coord coord) const;      //index into m_heads
+    void link(int slot);
+    void unlink(int slot);
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef JUNCTION_H
+#define JUNCTION_H
+
+#include "coord.h"
+#include "grid.h"
+
+#include <vector>
+#include <cstdint>
+
+/******************************* JUNCTION GRAPH ********************************/
+// The maze as ghosts see it: junction nodes joined by corridor edges.
+//
+// A corridor cell is one with exactly two ghost moves out of it, the same two
+// whether the ghost is eaten or not. A ghost that walked into a corridor cell
+// can't turn around, so it only has one move to make. Every other cell a ghost
+// can reach is a junction, where it has to pick a move toward its target.
+//
+// Each edge leaves a junction by one move and follows the corridor to the next
+// junction, storing its length and the cell after each move. Warps are taken
+// on the way, like the ghosts take them.
+//
+// corridor_move() answers in one lookup whether a ghost has a forced move. It
+// uses the same wall checks as GameCore::calc_ghost_destination, so skipping
+// the full evaluation in corridors never changes where a ghost goes.
+/********************************************************************************/
+enum class NavMove : std::uint8_t {right, down, left, up, none};
+
+struct JunctionEdge
+{
+  int from;                     //junction the edge leaves
+  int to;                       //junction the edge arrives at, -1 if the corridor dead ends
+  NavMove first;                //move out of the from junction
+  int length;                   //moves along the edge
+  std::vector<Coord> cells;     //the cell after each move, the last one is the to junction
+};
+
+class JunctionGraph
+{
+  public:
+    JunctionGraph() = default;
+
+    //walk the maze from the start coords
+    JunctionGraph(TileGrid grid, Coord left_warp, Coord right_warp, const std::vector<Coord>& starts);
+
+    const std::vector<Coord>& junctions() const;
+    const std::vector<JunctionEdge>& edges() const;
+    int corridor_cells() const;             //cells that arent junctions
+
+    bool is_junction(Coord coord) const;
+
+    //the only move a ghost heading this way can make from coord,
+    //NavMove::none if the ghost has to pick one
+    NavMove corridor_move(Coord coord, NavMove heading) const;
+
+  private:
+    int m_width {0};
+    int m_height {0};
+    std::vector<Coord> m_junctions;
+    std::vector<JunctionEdge> m_edges;
+    std::vector<int> m_junction_ids;              //junction id per tile, -1 if not a junction
+    std::vector<NavMove> m_corridor_moves;        //forced move per tile and heading
+    int m_corridor_cells {0};
+};
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "coord.h"
+#include "grid.h"
+#include "nav.h"
+#include "junction.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+/****************************** LEVEL LOCATIONS *******************************/
+// The single coords of a level: where pacman starts and the left/right warp pair.
+/********************************************************************************/
+struct LevelLocations
+{
+  Coord pacman_start;
+  Coord left_warp;
+  Coord right_warp;
+};
+
+/******************************** LEVEL GHOSTS *********************************/
+// A level has any number of ghosts. Each one has a kind, which picks how it
+// chases pacman (see ghosts.h), a start that is also its home, and a scatter
+// target.
+//
+// A levels ghosts are sorted by kind, so the ghosts of each kind are one run.
+/********************************************************************************/
+enum class GhostKind : std::uint32_t {blinky, pinky, clyde, inky};
+constexpr int GHOST_KINDS {4};
+
+struct LevelGhost
+{
+  Coord start;
+  Coord scatter;
+  GhostKind kind;
+  std::uint32_t reserved;
+};
+
+//the ghosts of one kind are ghosts first to last - 1
+struct GhostRange
+{
+  int first;
+  int last;
+};
+
+/******************************** LEVEL IMAGE *********************************/
+// The compiled form of a level, as written by pacman-levelc.
+//
+// An image is a LevelHeader followed by 8 byte aligned sections:
+//  -tiles: one Tile:: flag byte per cell, row major
+//  -points, power_ups: the starting cells as bitsets, in 64 bit words
+//  -nav_cells, nav_table, nav_flow_targets, nav_flows: the ghosts path distances,
+//   see nav.h. The table is empty for mazes with too many nav cells
+//  -ghosts: one LevelGhost per ghost, sorted by kind
+//
+// The header records each sections offset and size, so a level can be used
+// directly out of a mapped file. Bump LEVEL_VERSION whenever the layout changes.
+/********************************************************************************/
+constexpr char LEVEL_MAGIC[8] {'P','A','C','L','E','V','E','L'};
+constexpr std::uint32_t LEVEL_VERSION {3};
+
+enum class LevelSection {tiles, points, power_ups, nav_cells, nav_table, nav_flow_targets, nav_flows, ghosts};
+constexpr int LEVEL_SECTION_COUNT {8};
+
+struct LevelSectionEntry
+{
+  std::uint64_t offset;     //bytes from the start of the image
+  std::uint64_t size;       //bytes
+};
+
+struct LevelHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::int32_t width;
+  std::int32_t height;
+  std::uint32_t point_count;
+  std::uint32_t power_up_count;
+  std::uint32_t nav_cell_count;
+  std::uint32_t nav_flow_count;
+  std::uint32_t ghost_count;
+  LevelLocations locations;
+  LevelSectionEntry sections[LEVEL_SECTION_COUNT];   //indexed by LevelSection
+};
+
+/*********************************** LEVEL ***********************************/
+// All the locations and shapes that make up one maze.
+//
+// A level is built from two text files:
+//  -a locations file, where each symbol marks a single coord (starts, scatter targets, warps),
+//   and every ghost start symbol adds a ghost
+//  -a shapes file, where each symbol marks one cell of a shape (borders, points, ...)
+//
+// Both files use the same layout, the top left char is coord (0,0) and an 'e'
+// marks the end of a row. level_text.h has the parser.
+//
+// The default level is built into the binary, see embedded.cpp, so the game
+// doesnt need the assets directory. Files can still be loaded in its place.
+//
+// Either way a Level is a read only view over a level image. Images parsed from
+// text are kept in memory, compiled images are mmapped and used in place.
+// The junction graph isnt part of the image, it is built from the tiles on load.
+/********************************************************************************/
+class Level
+{
+  public:
+    Level() = default;
+    ~Level();
+
+    Level(Level&& other) noexcept;
+    Level& operator=(Level&& other) noexcept;
+    Level(const Level&) = delete;
+    Level& operator=(const Level&) = delete;
+
+    static Level from_image(std::vector<std::uint8_t> image);   //throws LevelError if invalid
+    static Level map_file(const std::string& file);             //throws LevelError if invalid
+
+    const LevelLocations& locations() const;
+    int width() const;
+    int height() const;
+
+    int ghost_count() const;
+    const LevelGhost& ghost(int n) const;       //n from 0 to ghost_count() - 1
+    GhostRange ghosts(GhostKind kind) const;
+
+    TileGrid grid() const;
+    TileBitsetView points() const;
+    TileBitsetView power_ups() const;
+    int point_count() const;
+    int power_up_count() const;
+
+    NavMap nav() const;
+    const JunctionGraph& junctions() const;
+
+    //the raw image, for writing it to a file
+    const std::uint8_t* data() const;
+    std::size_t size() const;
+
+    std::uint64_t checksum() const;   //hash of the whole image, identifies the level
+
+  private:
+    std::vector<std::uint8_t> m_image;    //backing memory for images built in memory
+    void* m_mapping {nullptr};            //backing memory for mapped files
+    const std::uint8_t* m_data {nullptr};
+    std::size_t m_size {0};
+    std::unique_ptr<JunctionGraph> m_junctions;   //heap allocated so it stays put when the level moves
+
+    const LevelHeader& header() const;
+    const void* section(LevelSection s) const;
+    void validate() const;
+    void build_junctions();
+    void release();
+};
+
+//a level shared read only by every game playing it, freed when the last one lets go
+using SharedLevel = std::shared_ptr<const Level>;
+
+//thrown when a level file is missing or malformed
+class LevelError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+//compile the contents of a levels two text files into an image, throws LevelError on failure
+std::vector<std::uint8_t> compile_level(const std::string& locations_text, const std::string& shapes_text);
+
+//lay out an image for a levels parsed tiles, width * height flags, its locations and
+//its ghost_count ghosts, which are sorted by kind if they arent already
+std::vector<std::uint8_t> build_level_image(const LevelLocations& locations, int width, int height,
+                                            const std::uint8_t* tiles,
+                                            const LevelGhost* ghosts, int ghost_count);
+
+//parse a level from the contents of its two files, throws LevelError on failure
+Level parse_level(const std::string& locations_text, const std::string& shapes_text);
+
+//compile a levels two text files into an image, throws LevelError on failure.
+//The files are read a block at a time, the locations file once and the shapes
+//file twice, so a large levels text is never held in memory
+std::vector<std::uint8_t> compile_level_files(const std::string& locations_file, const std::string& shapes_file);
+
+//compile_level_files() into a level, throws LevelError on failure
+Level load_level(const std::string& locations_file, const std::string& shapes_file);
+
+//text_checksum() of a file, continuing from hash, read a block at a time. Throws LevelError
+//if it cant be read
+std::uint64_t level_file_checksum(const std::string& file, std::uint64_t hash = 14695981039346656037u);
+
+//read a whole file in one go, throws LevelError if it cant be opened
+std::string read_level_file(const std::string& file);
+
+//the levels built into the binary, parsed at compile time from assets/level_*_*.txt
+int embedded_level_count();
+Level embedded_level(int index = 0);                //index from 0, level_1 first
+std::uint64_t embedded_level_checksum(int index);   //hash of the levels text, see text_checksum()
+
+#endif
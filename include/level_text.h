@@ -0,0 +1,284 @@
+#ifndef LEVEL_TEXT_H
+#define LEVEL_TEXT_H
+
+#include "coord.h"
+#include "grid.h"
+#include "level.h"
+
+#include <string_view>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+
+/********************************* LEVEL TEXT **********************************/
+// The parser for a levels two text files, see Level for the format.
+//
+// It is all constexpr, so the same code parses level files at runtime, where a
+// malformed level throws a LevelError from compile_level, and the levels built
+// into the binary at compile time, where it fails a static_assert instead.
+//
+// Every parse walks its text through scan_level_text(text, f), so a text is
+// anything with a scan_level_text overload: a string_view, the LevelMarks kept
+// from a locations file, or a file read a block at a time (level.cpp). That way
+// a large level is parsed straight from its files without holding them as text.
+/********************************************************************************/
+
+//the symbol for each coord in the locations file
+struct LocationSymbol
+{
+  char symbol;
+  Coord LevelLocations::* location;
+  const char* name;
+};
+
+constexpr LocationSymbol LOCATION_SYMBOLS[] {
+  {'<', &LevelLocations::pacman_start, "pacman start"},
+  {'l', &LevelLocations::left_warp, "left warp"},
+  {'r', &LevelLocations::right_warp, "right warp"},
+};
+
+constexpr int LOCATION_SYMBOL_COUNT {static_cast<int>(std::size(LOCATION_SYMBOLS))};
+
+//the start and scatter symbols of each kind of ghost in the locations file, indexed by GhostKind
+struct GhostSymbol
+{
+  char start;
+  char scatter;
+  GhostKind kind;
+  const char* name;
+};
+
+constexpr GhostSymbol GHOST_SYMBOLS[] {
+  {'B', 'b', GhostKind::blinky, "blinky"},
+  {'P', 'p', GhostKind::pinky, "pinky"},
+  {'C', 'c', GhostKind::clyde, "clyde"},
+  {'I', 'i', GhostKind::inky, "inky"},
+};
+
+static_assert(std::size(GHOST_SYMBOLS) == GHOST_KINDS, "every kind of ghost needs its symbols");
+
+//the tile flag for each symbol in the shapes file
+constexpr std::uint8_t shape_flag(char symbol)
+{
+  switch(symbol) {
+    case '#': return Tile::BORDER;
+    case 'x': return Tile::INV_WALL;
+    case '.': return Tile::POINT;
+    case '!': return Tile::POWER_UP;
+    case '$': return Tile::GHOST_HOME;
+    default:  return Tile::EMPTY;
+  }
+}
+
+//walk the text once and call f(c, coord) for every char that isnt an end of row.
+//Returns the coord after the text, pass it as start to carry on with the texts next part
+template<typename F>
+constexpr Coord scan_level_text(std::string_view text, F f, Coord start = Coord{0,0})
+{
+  Coord coord {start};  //the top left of the file will have coord (0,0)
+
+  for(char c : text) {
+    if(c == 'e') {      //if we are at the end of the line
+      coord.x = 0;      //reset x
+      coord.y++;        //move y down a line
+    } else {
+      f(c, coord);
+      coord.x++;        //every other char moves x to the right
+    }
+  }
+  return coord;
+}
+
+//a location or ghost symbol and its coord, a locations file is mostly blanks
+//so a large ones is kept as just these
+struct LevelMark
+{
+  char symbol;
+  Coord coord;
+};
+
+using LevelMarks = std::vector<LevelMark>;
+
+constexpr bool is_level_mark(char c)
+{
+  for(const LocationSymbol& symbol : LOCATION_SYMBOLS) {
+    if(c == symbol.symbol)
+      return true;
+  }
+  for(const GhostSymbol& symbol : GHOST_SYMBOLS) {
+    if(c == symbol.start || c == symbol.scatter)
+      return true;
+  }
+  return false;
+}
+
+//the marks in the order they were read, so every parse finds the same coords it would in the text
+template<typename F>
+void scan_level_text(const LevelMarks& marks, F f)
+{
+  for(const LevelMark& mark : marks) {
+    f(mark.symbol, mark.coord);
+  }
+}
+
+struct LevelTextSize
+{
+  int width;            //the longest row
+  int height;           //rows up to the last one with a cell in it
+};
+
+template<typename Text>
+constexpr LevelTextSize level_text_size(const Text& shapes_text)
+{
+  LevelTextSize size {0, 0};
+  scan_level_text(shapes_text, [&](char, Coord coord) {
+    size.width = std::max(size.width, coord.x + 1);
+    size.height = coord.y + 1;
+  });
+  return size;
+}
+
+struct LevelTextLocations
+{
+  LevelLocations locations;
+  int missing;          //index in LOCATION_SYMBOLS of the first symbol not found, -1 if none
+};
+
+//locations are the first coord their symbol appears at
+template<typename Text>
+constexpr LevelTextLocations parse_locations(const Text& locations_text)
+{
+  LevelTextLocations parsed {};
+  bool found[LOCATION_SYMBOL_COUNT] {};
+
+  scan_level_text(locations_text, [&](char c, Coord coord) {
+    for(int i = 0; i < LOCATION_SYMBOL_COUNT; i++) {
+      if(c == LOCATION_SYMBOLS[i].symbol && !found[i]) {
+        parsed.locations.*LOCATION_SYMBOLS[i].location = coord;
+        found[i] = true;
+      }
+    }
+  });
+
+  parsed.missing = -1;
+  for(int i = 0; i < LOCATION_SYMBOL_COUNT && parsed.missing < 0; i++) {
+    if(!found[i])
+      parsed.missing = i;
+  }
+  return parsed;
+}
+
+struct LevelTextGhosts
+{
+  int count;            //one ghost per start symbol
+  int missing_scatter;  //index in GHOST_SYMBOLS of the first kind with starts but no scatter, -1 if none
+};
+
+template<typename Text>
+constexpr LevelTextGhosts count_ghosts(const Text& locations_text)
+{
+  int starts[GHOST_KINDS] {};
+  int scatters[GHOST_KINDS] {};
+
+  scan_level_text(locations_text, [&](char c, Coord) {
+    for(int kind = 0; kind < GHOST_KINDS; kind++) {
+      starts[kind] += c == GHOST_SYMBOLS[kind].start;
+      scatters[kind] += c == GHOST_SYMBOLS[kind].scatter;
+    }
+  });
+
+  LevelTextGhosts counted {0, -1};
+  for(int kind = 0; kind < GHOST_KINDS; kind++) {
+    counted.count += starts[kind];
+    if(starts[kind] > 0 && scatters[kind] == 0 && counted.missing_scatter < 0)
+      counted.missing_scatter = kind;
+  }
+  return counted;
+}
+
+//write the ghosts into ghosts, which must hold count_ghosts().count of them.
+//They come out sorted by kind, each kinds in the order their starts are read.
+//The nth ghost of a kind scatters to the nth scatter of its kind, or to the
+//last one if there are fewer scatters than ghosts
+template<typename Text>
+constexpr void parse_ghosts(const Text& locations_text, LevelGhost* ghosts)
+{
+  int count {0};
+
+  for(const GhostSymbol& symbol : GHOST_SYMBOLS) {
+    int first = count;
+    scan_level_text(locations_text, [&](char c, Coord coord) {
+      if(c == symbol.start)
+        ghosts[count++] = LevelGhost{coord, coord, symbol.kind, 0};
+    });
+
+    int scatters {0};
+    scan_level_text(locations_text, [&](char c, Coord coord) {
+      if(c != symbol.scatter)
+        return;
+      for(int n = first + scatters; n < count; n++) {   //this and every later ghost, until the next scatter
+        ghosts[n].scatter = coord;
+      }
+      scatters++;
+    });
+  }
+}
+
+//write the flag of every cell into tiles, which must hold width * height cells set to Tile::EMPTY
+template<typename Text>
+constexpr void parse_tiles(const Text& shapes_text, int width, std::uint8_t* tiles)
+{
+  scan_level_text(shapes_text, [&](char c, Coord coord) {
+    tiles[coord.y * width + coord.x] = shape_flag(c);
+  });
+}
+
+template<typename Text>
+constexpr bool has_border(const Text& shapes_text)
+{
+  bool border {false};
+  scan_level_text(shapes_text, [&](char c, Coord) { border = border || c == '#'; });
+  return border;
+}
+
+//64 bit FNV-1a of a levels text, continuing from hash to chain several texts
+constexpr std::uint64_t text_checksum(std::string_view text, std::uint64_t hash = 14695981039346656037u)
+{
+  for(char c : text) {
+    hash ^= static_cast<std::uint8_t>(c);
+    hash *= 1099511628211u;
+  }
+  return hash;
+}
+
+/******************************* EMBEDDED LEVEL ********************************/
+// A level parsed at compile time, with its tiles, locations and ghosts in static storage.
+//
+// embedded.cpp checks each levels text with static_asserts before parsing it,
+// parse_embedded_level() itself assumes the text is well formed.
+/********************************************************************************/
+template<int Width, int Height, int Ghosts>
+struct EmbeddedLevel
+{
+  LevelLocations locations;
+  std::uint8_t tiles[Width * Height];
+  LevelGhost ghosts[Ghosts];
+
+  static constexpr int width {Width};
+  static constexpr int height {Height};
+  static constexpr int ghost_count {Ghosts};
+};
+
+template<int Width, int Height, int Ghosts>
+constexpr EmbeddedLevel<Width, Height, Ghosts> parse_embedded_level(std::string_view locations_text,
+                                                                    std::string_view shapes_text)
+{
+  EmbeddedLevel<Width, Height, Ghosts> level {};
+  level.locations = parse_locations(locations_text).locations;
+  parse_tiles(shapes_text, Width, level.tiles);
+  parse_ghosts(locations_text, level.ghosts);
+  return level;
+}
+
+#endif
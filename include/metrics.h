@@ -0,0 +1,115 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <stdexcept>
+
+/********************************** HISTOGRAM **********************************/
+// A lock-free histogram with HDR style buckets.
+//
+// Values below 16 get a bucket each. Above that every power of 2 is split into
+// 16 linear sub-buckets, so a bucket is never more than 1/16 wider than the
+// values in it, from nanoseconds up to hours, in a fixed array of counters.
+//
+// record() is three relaxed atomic adds, so the game loop can record into a
+// histogram while another thread reads it. A reader can see a count that is
+// one or two values behind the buckets, never a torn value.
+/********************************************************************************/
+class Histogram
+{
+  public:
+    static constexpr int SUB_BITS {4};
+    static constexpr int SUB_BUCKETS {1 << SUB_BITS};
+    static constexpr int BUCKETS {SUB_BUCKETS + (64 - SUB_BITS) * SUB_BUCKETS};
+
+    void record(std::uint64_t value);
+
+    std::uint64_t count() const;
+    std::uint64_t sum() const;
+    std::uint64_t bucket(int index) const;          //values recorded into a bucket
+
+    static int bucket_index(std::uint64_t value);
+    static std::uint64_t bucket_max(int index);      //largest value a bucket holds
+
+  private:
+    std::atomic<std::uint64_t> m_buckets[BUCKETS] {};
+    std::atomic<std::uint64_t> m_count {0};
+    std::atomic<std::uint64_t> m_sum {0};
+};
+
+//a lock-free count that only goes up
+class Counter
+{
+  public:
+    void add(std::uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<std::uint64_t> m_value {0};
+};
+
+/*********************************** METRICS ***********************************/
+// Everything the game measures about itself while it runs.
+//
+// GameCore counts what happens in the game from its scoring and collision
+// checks, Game times each tick and frame, and the ncurses backend measures what
+// it writes to the terminal. Recording is only ever an atomic add.
+//
+// exposition() formats it all as Prometheus text, durations in seconds.
+/********************************************************************************/
+struct Metrics
+{
+  Histogram tick_ns;                  //a tick, from reading input to the end phase, without the wait,
+                                      //only ticks with no animation, prompt or message
+  Histogram render_ns;                //drawing a frame
+  Histogram input_to_move_ns;         //reading a move key to drawing the frame it moved pacman in
+  Histogram terminal_write_bytes;     //bytes written to the terminal for each frame
+
+  Counter ticks;
+  Counter pellets_eaten;
+  Counter power_ups_eaten;
+  Counter ghosts_eaten;
+  Counter deaths;
+  Counter level_resets;               //the board put back, for a new level or a new game
+
+  std::string exposition() const;
+};
+
+/******************************** METRICSSERVER ********************************/
+// Serves Metrics::exposition() on a Unix domain socket from a background thread.
+//
+// Each connection gets one HTTP/1.0 response with the metrics and is closed,
+// so a scraper can read it with curl --unix-socket, or a plain client can just
+// connect and read. The game thread never touches the socket.
+/********************************************************************************/
+class MetricsServer
+{
+  public:
+    MetricsServer(const Metrics& metrics, const std::string& socket_path);   //throws MetricsError
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+  private:
+    const Metrics& m_metrics;
+    std::string m_path;
+    int m_socket {-1};
+    std::atomic<bool> m_stop {false};
+    std::thread m_thread;
+
+    void serve();                     //the server threads loop
+    void respond(int client);
+};
+
+//thrown when the metrics socket cant be set up
+class MetricsError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+#endif
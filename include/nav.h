@@ -0,0 +1,95 @@
+#ifndef NAV_H
+#define NAV_H
+
+#include "coord.h"
+#include "grid.h"
+
+#include <vector>
+#include <cstdint>
+
+/*********************************** NAV ***********************************/
+// Path distances through the maze, for steering the ghosts.
+//
+// A nav cell is a cell a ghost can stand on, found by walking the maze the way
+// ghosts move: 2 cells left or right, 1 cell up or down, never into a border.
+// Left and right moves cant enter an invisible wall, down moves can only enter
+// one while eaten, and up moves always can. Stepping onto a warp lands on the
+// other warp, so each warp cell shares its partners nav cell.
+//
+// Distances are stored as fields: one 16 bit entry per nav cell holding the
+// number of ghost moves from that cell to the fields target.
+//  -flow fields are built for the fixed targets of a level, the ghost homes
+//   with the eaten rules and the scatter targets with the normal rules
+//  -the distance table holds a field for every nav cell as a target, with the
+//   normal rules. It grows with the square of the cells, so it is only built
+//   for mazes of up to NAV_MAX_TABLE_CELLS cells
+/********************************************************************************/
+enum class NavRules : std::uint32_t {normal, eaten};
+
+constexpr std::uint16_t NAV_NONE {0xffff};          //no nav cell, or no path
+constexpr int NAV_MAX_CELLS {0xfffe};               //cell ids have to fit a field entry
+constexpr int NAV_MAX_TABLE_CELLS {2048};           //a table this big is 8 MB
+
+//the target and rules a flow field was built for
+struct NavFlowTarget
+{
+  Coord target;
+  NavRules rules;
+  std::uint32_t reserved;
+};
+
+/********************************** NAVMAP ***********************************/
+// A read only view over the nav sections of a level.
+/********************************************************************************/
+class NavMap
+{
+  public:
+    NavMap() = default;
+    NavMap(int width, int height, const std::uint16_t* cell_ids, int cell_count,
+           const std::uint16_t* table, const NavFlowTarget* flow_targets,
+           const std::uint16_t* flows, int flow_count);
+
+    int cell_count() const;
+    bool has_table() const;
+
+    int cell(Coord coord) const;      //nav cell id of coord, or -1
+
+    //field of distances to target, a flow field if there is one else a table row,
+    //nullptr if neither covers the target
+    const std::uint16_t* field(Coord target, NavRules rules) const;
+
+    //moves from coord to the fields target, NAV_NONE if there is no path
+    int distance(const std::uint16_t* field, Coord coord) const;
+
+    //moves from one coord to another with the normal rules, -1 if there is no table for it
+    int path_distance(Coord from, Coord to) const;
+
+  private:
+    int m_width {0};
+    int m_height {0};
+    const std::uint16_t* m_cell_ids {nullptr};    //a nav cell id per tile, NAV_NONE if none
+    int m_cell_count {0};
+    const std::uint16_t* m_table {nullptr};       //field of target t starts at t * m_cell_count
+    const NavFlowTarget* m_flow_targets {nullptr};
+    const std::uint16_t* m_flows {nullptr};       //field i starts at i * m_cell_count
+    int m_flow_count {0};
+};
+
+/********************************* NAV BUILD *********************************/
+// The nav sections of a level, built from its tiles when it is compiled.
+/********************************************************************************/
+struct NavBuild
+{
+  std::vector<std::uint16_t> cell_ids;
+  int cell_count {0};
+  std::vector<std::uint16_t> table;               //empty if the maze is too big
+  std::vector<NavFlowTarget> flow_targets;
+  std::vector<std::uint16_t> flows;
+};
+
+//walk the maze from the start coords and build the cells, table and flow fields.
+//If more cells are found than NAV_MAX_CELLS the build is left empty.
+NavBuild build_nav(TileGrid grid, Coord left_warp, Coord right_warp,
+                   const std::vector<Coord>& starts, const std::vector<NavFlowTarget>& flow_targets);
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include "level.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <deque>
+#include <cstdint>
+
+/********************************** LEVEL PACK **********************************/
+// The mazes a game cycles through as its level goes up: level n plays maze
+// (n - 1) % size(), so after the last maze the pack starts over.
+//
+// A pack is the levels built into the binary, a single level, or the mazes
+// listed in a manifest file, one per line:
+//
+//   # comments and blank lines are skipped
+//   level_1.lvl                                  a level compiled by pacman-levelc
+//   level_2_locations.txt level_2_shapes.txt     a levels two text files
+//
+// Paths are relative to the manifest.
+//
+// Mazes are loaded on first use. prefetch(n) loads, checks and precomputes
+// maze n on the packs loader thread while the game plays the one before it, so
+// level(n) only hands over a pointer when the level changes. A load that fails
+// throws its LevelError from level(n). prefetch() only queues the load, so the
+// game never waits on a file, not even for a prefetch it no longer needs.
+//
+// reload(maze) reads a mazes files again, for when they were edited, and
+// replaces it for every game that asks for it after.
+//
+// The pack keeps its first maze, where every game starts, and the last one it
+// prefetched. Any other maze stays loaded while a game still plays it. Many
+// games, on any threads, can share one pack.
+/********************************************************************************/
+class LevelPack
+{
+  public:
+    ~LevelPack();                               //stops the loader thread, once the maze its loading is done
+
+    LevelPack(const LevelPack&) = delete;
+    LevelPack& operator=(const LevelPack&) = delete;
+
+    static std::shared_ptr<LevelPack> built_in();                         //the levels embedded in the binary
+    static std::shared_ptr<LevelPack> load(const std::string& manifest);  //throws LevelError
+
+    //a pack of one level, loaded on first use
+    static std::shared_ptr<LevelPack> compiled_level(const std::string& file);
+    static std::shared_ptr<LevelPack> text_level(const std::string& locations, const std::string& shapes);
+
+    int size() const;                           //number of mazes
+    int maze(int game_level) const;             //which maze a game level plays
+
+    SharedLevel level(int game_level);          //the maze a game level plays, throws LevelError
+    void prefetch(int game_level);              //start loading a game levels maze in the background
+
+    std::vector<std::string> files(int maze) const;   //what a maze is loaded from, none if built in
+    SharedLevel reload(int maze);               //load a maze from its files again, throws LevelError
+
+    //identifies the mazes and their order, for replays. For a pack of one level
+    //it is the levels own checksum. Throws LevelError if a file cant be read
+    std::uint64_t checksum();
+
+  private:
+    //where one maze comes from
+    struct Source
+    {
+      int embedded {-1};          //index of a built in level, or
+      std::string compiled;       //a compiled level file, or
+      std::string locations;      //a levels text files
+      std::string shapes;
+    };
+
+    explicit LevelPack(std::vector<Source> sources);
+
+    std::vector<Source> m_sources;
+
+    mutable std::mutex m_mutex;                   //guards everything below
+    std::vector<std::weak_ptr<const Level>> m_loaded;   //each maze, while anyone holds it
+    std::vector<int> m_reloads;                   //times each maze was reloaded, so a stale load isnt kept
+    SharedLevel m_first;                          //maze 0, kept for new games
+    int m_prefetch_index {-1};
+    std::shared_future<SharedLevel> m_prefetch;   //the last maze prefetched, holds it once loaded
+
+    //a maze for the loader thread to load
+    struct Prefetch
+    {
+      int index;
+      int reloads;                                //m_reloads of the maze when it was asked for
+      std::promise<SharedLevel> result;
+    };
+
+    std::deque<Prefetch> m_queue;                 //prefetches not started yet, oldest first
+    std::condition_variable m_wake;               //signalled when one is queued, or on stopping
+    bool m_stop {false};
+    std::thread m_loader;                         //started by the first prefetch
+
+    SharedLevel load_maze(int index) const;       //load a maze on the calling thread
+    void keep(int index, const SharedLevel& level, int reloads);
+    void load_prefetches();                       //the loader threads loop
+};
+
+#endif
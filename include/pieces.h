@@ -3,41 +3,48 @@
 
 #include "config.h"
 #include "coord.h"
+#include "grid.h"
+#include "level.h"
+#include "canvas.h"
 
-#include <list>
-#include <ncurses.h>
+#include <cstdint>
 
 /********************************** PIECE ***********************************/
 // A piece is the most generic type of object that can be drawn on screen
 //
 // This class provides some common functionality used by all pieces:
-//  -draw(window): draw the pieces shape onto the window
+//  -draw(canvas): draw the pieces shape onto the canvas
 //  -blink(): blink the pieces symbol (i.e switch from 'x' to ' ' and vice versa)
 //  -in(coord): check if this pieces coords overlap with a single coordinate
 //  -in(piece): check if this pieces coords overlap with another pieces coords
+//  -revision(): a counter that changes whenever the way the piece draws changes
 /********************************************************************************/
 class Piece
 {
   public:
-    Piece(Coord location, std::list<Coord> shape, char symbol);
+    Piece(Coord location, Shape shape, char symbol);
+    virtual ~Piece() = default;
 
     //getters
-    const std::list<Coord>& shape() const;
+    Shape shape() const;
     Coord location() const;
-    char symbol() const;     //returns char in m_blinker[0], not neccesarily m_symbol
+    char symbol() const;     //Symbols::INVISIBLE while blinked out, not neccesarily m_symbol
+    unsigned revision() const;
 
-    void draw(WINDOW* w);    //draw m_shape at m_location on the window
+    virtual void draw(Canvas& canvas);   //draw m_shape at m_location on the canvas
     void blink();
     bool in(const Piece* other);
-    bool in(Coord coord);
+    virtual bool in(Coord coord);
 
   protected:
     Coord m_location;           //coord relative to the windows coords
-    std::list<Coord> m_shape;   //coords relative to m_location
+    Shape m_shape;              //coords relative to m_location
     char m_symbol;
-    const char* m_blinker[2] {&m_symbol, &Symbols::INVISIBLE};
+    bool m_blinked {false};     //blinked out, a flag rather than pointers so pieces can be copied
+    unsigned m_revision {0};
 
     void set_symbol(char symbol);
+    void changed();          //bump the revision, call whenever the drawn cells or symbol change
 };
 
 /******************************** DYNAMIC PIECE ********************************/
@@ -50,6 +57,10 @@ class Piece
 // This class provides some common functionality used by all dynamic pieces
 //  -movement functions: move piece in a certain dir
 //  -jump: jump to an arbitrary coord
+//  -track(index): add the piece to a PieceIndex, which every move then updates
+//
+// Pieces built from a level also have load(level), which moves their home, and
+// whatever else they read from a level, into another levels maze.
 /********************************************************************************/
 
 enum Momentum {up, down, left, right, still};
@@ -57,7 +68,13 @@ enum Momentum {up, down, left, right, still};
 class DynamicPiece : public Piece
 {
   public:
-    DynamicPiece(Coord location, std::list<Coord> shape, char symbol, Momentum start_m);
+    DynamicPiece(Coord location, Shape shape, char symbol, Momentum start_m);
+
+    //a tracked piece owns its slot of the index, so it can be moved, taking the slot with it, but not copied
+    DynamicPiece(const DynamicPiece&) = delete;
+    DynamicPiece& operator=(const DynamicPiece&) = delete;
+    DynamicPiece(DynamicPiece&& other) noexcept;
+    DynamicPiece& operator=(DynamicPiece&& other) noexcept;
 
     //getter
     Momentum momentum() const;
@@ -78,10 +95,21 @@ class DynamicPiece : public Piece
 
     //are we at the home coord
     bool is_home();
+    Coord home() const;
+    void set_home(Coord home);    //move the home, the piece stays where it is
+
+    //add the piece to index and keep it up to date as the piece moves, nullptr to stop
+    void track(PieceIndex* index);
 
   protected:
     Momentum m_momentum;
     Coord m_home;
+
+  private:
+    PieceIndex* m_index {nullptr};
+    int m_slot {-1};
+
+    void moved();           //tell m_index where the piece is now
 };
 
 /*********************************** PACMAN ************************************/
@@ -99,7 +127,9 @@ enum class EatenFlag {not_eaten, eaten};
 class PacMan : public DynamicPiece
 {
   public:
-    PacMan();
+    explicit PacMan(const Level& level);
+
+    void load(const Level& level);
 
     int points() const;
     void inc_points(int inc);
@@ -122,7 +152,8 @@ class PacMan : public DynamicPiece
 
 
 /********************************** GHOST ***********************************/
-//Our parent for all the ghost types.
+//A ghost of any kind. Its kind picks its symbols here and how it chases pacman
+//in the core, see ghosts.h
 //
 //Ghosts have 5 states that determine their behavior
 //  -chase: chase the target
@@ -131,15 +162,19 @@ class PacMan : public DynamicPiece
 //  -frightened: go in a random direction
 //  -eaten: go back to their home coordinate
 /********************************************************************************/
-enum class PursuitState;    //forward declaration from game.h
+enum class PursuitState;    //forward declaration from core.h
 
 enum class GhostState {chase, scatter, turn_around, frightened, eaten};
 
 class Ghost : public DynamicPiece
 {
   public:
+    explicit Ghost(const LevelGhost& ghost);
+
     //getters
+    GhostKind kind() const;
     GhostState state() const;
+    Coord scatter_target() const;
     int value();
 
     //setters
@@ -147,6 +182,7 @@ class Ghost : public DynamicPiece
     void set_state(PursuitState pursuit_state);   //use the games current PursuitState to calc and set the state
 
     bool eats(PacMan* p);         //check if ghost eats pacman
+    bool edible() const;          //can pacman eat the ghost in its state
 
     bool check_eaten(PacMan* p);  //check if ghost is eaten by pacman and set the eaten state
     bool eaten();                 //return true if ghost is being eaten
@@ -154,14 +190,16 @@ class Ghost : public DynamicPiece
 
     void reset();                 //resets location and momentum
 
-  protected:
-    //protected constructor, we dont want to ever make a plain ghost
-    Ghost(Coord coord, char chase_symbol, char fright_symbol, Coord scatter_coord);
+    void load(const LevelGhost& ghost);   //take another levels ghost, the ghost stays where it is
 
   private:
+    GhostKind m_kind;
+
     GhostState m_ghost_state  {GhostState::scatter};
     EatenFlag m_eaten_flag {EatenFlag::not_eaten};
 
+    Coord m_scatter_target;
+
     char m_chase_symbol;
     char m_fright_symbol;
     char m_eaten_symbol {Symbols::GHOST_EATEN};
@@ -171,45 +209,44 @@ class Ghost : public DynamicPiece
     void update_symbol();                   //update symbol based on current state
 };
 
-/************************ PINKY, BLINKY, INKY AND CLYDE ************************/
-
-class Pinky : public Ghost
+/******************************** GRIDPIECE ********************************/
+// A static piece whose cells are every tile of the level grid with a certain flag.
+//
+// The cells are read straight from the grid, so the piece keeps no shape of its own.
+/********************************************************************************/
+class GridPiece : public Piece
 {
   public:
-    Pinky();
-};
+    GridPiece(TileGrid grid, std::uint8_t flag, char symbol);
 
-class Blinky : public Ghost
-{
-  public:
-    Blinky();
-};
+    void draw(Canvas& canvas) override;
+    bool in(Coord coord) override;
 
-class Clyde : public Ghost
-{
-  public:
-    Clyde();
-};
+  protected:
+    void set_grid(TileGrid grid);
 
-class Inky : public Ghost
-{
-  public:
-    Inky();
+  private:
+    TileGrid m_grid;
+    std::uint8_t m_flag;
 };
 
 /***************************** BORDERS and INVWALLS *****************************/
 //  All the border and invisible wall pieces for our game.
 /********************************************************************************/
-class Borders : public Piece
+class Borders : public GridPiece
 {
   public:
-    Borders();
+    explicit Borders(const Level& level);
+
+    void load(const Level& level);
 };
 
-class InvWalls : public Piece 
+class InvWalls : public GridPiece
 {
   public:
-    InvWalls();
+    explicit InvWalls(const Level& level);
+
+    void load(const Level& level);
 };
 
 /************************** WARP, LEFTWARP, RIGHTWARP ***************************/
@@ -226,19 +263,26 @@ class Warp : public Piece
 class LeftWarp : public Warp
 {
   public:
-    LeftWarp();
+    explicit LeftWarp(const Level& level);
+
+    void load(const Level& level);
 };
 
 class RightWarp : public Warp
 {
   public:
-    RightWarp();
+    explicit RightWarp(const Level& level);
+
+    void load(const Level& level);
 };
 
 /********************************** SCORINGPIECE ***********************************/
 // A class for non-ghost scoring pieces.
 //
-// When a score happens the coord that was eaten gets removed from the shape
+// The starting cells are a bitset owned by the level. The cells still on the
+// board are tracked in a copy of it, along with a live count of them.
+//
+// When a score happens the bit for the eaten coord gets cleared
 /*******************************************************************************/
 
 enum class ScoreFlag {no_score, score};
@@ -246,19 +290,30 @@ enum class ScoreFlag {no_score, score};
 class ScoringPiece : public Piece
 {
   public:
-    ScoringPiece(Coord location, std::list<Coord> shape, char symbol, int value);
+    ScoringPiece(Coord location, TileBitsetView cells, int n_cells, char symbol, int value);
 
     int value();
 
-    bool check_score(Piece* p);   //if its a score: set the flag, remove the scoring coord, return true
+    void draw(Canvas& canvas) override;  //only draws the cells that have not been eaten
+    bool in(Coord coord) override;  //only checks the cells that have not been eaten
+
+    bool check_score(Piece* p);   //if its a score: set the flag, clear the scoring coord, return true
     bool score();                 //return true if score flag is set
     void reset_score_flag();
 
-    void reset();                 //reset shape to original shape
+    int remaining() const;        //number of cells that have not been eaten
+
+    void reset();                 //put every eaten cell back on the board
+
+  protected:
+    void set_cells(TileBitsetView cells, int n_cells);   //start from another levels cells
 
   private:
     ScoreFlag m_score_flag {ScoreFlag::no_score};
-    std::list<Coord> m_original_shape;
+    TileBitsetView m_original_cells;  //cells at the start of the level, relative to m_location
+    TileBitset m_cells;               //cells still on the board
+    int m_original_count;
+    int m_remaining;
     int m_value;
 
 };
@@ -270,7 +325,9 @@ class ScoringPiece : public Piece
 class Points : public ScoringPiece
 {
   public:
-    Points();
+    explicit Points(const Level& level);
+
+    void load(const Level& level);
 
     bool all_eaten();   //return true if all points were eaten
 };
@@ -287,9 +344,11 @@ enum class PowerUpState {off, active};
 class PowerUps : public ScoringPiece
 {
   public:
-    PowerUps();
+    explicit PowerUps(const Level& level);
+
+    void load(const Level& level);
 
-    PowerUpState state();
+    PowerUpState state() const;
 
     void set_state(PowerUpState new_state);
 
@@ -0,0 +1,66 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/********************************** WORKPOOL ***********************************/
+// A fixed set of worker threads that run batches of indexed tasks.
+//
+// run(count, task) calls task(index, worker) once for every index in
+// [0, count) and returns when they have all finished. The indices are split
+// into one contiguous run per worker. Each worker takes tasks from the front
+// of its own queue, and once that is empty steals from the back of another
+// workers queue, so workers that drew short tasks help out the ones that
+// drew long ones.
+//
+// worker is the index of the thread running the task, in [0, threads()), so a
+// task can use per worker state without locking. If a task throws, the rest
+// of the batch still runs and run() rethrows the first exception.
+/********************************************************************************/
+class WorkPool
+{
+  public:
+    explicit WorkPool(int threads);     //at least one thread
+    ~WorkPool();
+
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    int threads() const;
+
+    void run(long count, const std::function<void(long, int)>& task);
+
+    long steals() const;                //tasks run by a worker other than the one they were given to
+
+  private:
+    struct Queue
+    {
+      std::mutex mutex;
+      std::deque<long> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;   //one per worker
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;                             //guards everything below
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(long, int)>* m_task {nullptr};
+    long m_batch {0};                               //batches started, wakes the workers
+    int m_busy {0};                                 //workers still on the current batch
+    bool m_stop {false};
+    long m_steals {0};
+    std::exception_ptr m_error;
+
+    void work(int worker);
+    bool next_task(int worker, long& index, bool& stolen);
+};
+
+#endif
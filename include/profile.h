@@ -0,0 +1,139 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstdint>
+
+/********************************** PROFILER ***********************************/
+// Times each phase of a tick, built only when PACMAN_PROFILE is defined
+// (make PROFILE=1). Without it PROFILE_SCOPE expands to nothing and none of
+// the classes below exist, so a normal build carries no instrumentation.
+//
+// PROFILE_SCOPE(profiler, phase) times the rest of its enclosing block.
+// Each timing is recorded twice:
+//  -into a window of the last PROFILE_WINDOW ticks, which the stats overlay
+//   reads p50 and p99 from
+//  -into a lock-free single producer, single consumer ring buffer, drained by
+//   a writer thread when timings are being exported, so the game loop never
+//   waits on a file
+//
+// The writer streams a CSV with a row per tick and a column per phase, and/or a
+// Chrome trace-event JSON file with one complete event per phase, which can be
+// opened in Perfetto or chrome://tracing.
+/********************************************************************************/
+enum class ProfilePhase : std::uint8_t {input, pacman, ghosts, score, draw, resets, end, wait};
+
+constexpr int PROFILE_PHASES {8};
+
+#ifdef PACMAN_PROFILE
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+constexpr int PROFILE_WINDOW {256};                 //ticks the overlay percentiles cover
+constexpr std::size_t PROFILE_RING_SIZE {1 << 16};  //samples the ring holds, a power of 2
+
+const char* phase_name(ProfilePhase phase);
+
+struct ProfileSample
+{
+  long tick;
+  ProfilePhase phase;
+  std::int64_t start_ns;        //since the profiler started
+  std::int64_t duration_ns;
+};
+
+//a fixed size queue for one producer thread and one consumer thread
+class SampleRing
+{
+  public:
+    explicit SampleRing(std::size_t size);      //size must be a power of 2
+
+    bool push(const ProfileSample& sample);     //false if the ring is full
+    bool pop(ProfileSample& sample);            //false if the ring is empty
+
+  private:
+    std::vector<ProfileSample> m_slots;
+    std::size_t m_mask;
+
+    alignas(64) std::atomic<std::size_t> m_head {0};   //next slot to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> m_tail {0};   //next slot to push, written by the producer
+};
+
+class Profiler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    Profiler();
+    ~Profiler();      //drains the ring and closes the export files
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    //start exporting to either file, empty for none, throws ProfileError if one cant be opened
+    void export_to(const std::string& csv_file, const std::string& trace_file);
+
+    void begin_tick(long tick);
+    void record(ProfilePhase phase, Clock::time_point start, Clock::time_point end);
+
+    std::int64_t percentile_ns(ProfilePhase phase, int p) const;    //over the last PROFILE_WINDOW ticks
+    long dropped() const;           //samples lost because the ring was full
+
+  private:
+    Clock::time_point m_epoch;
+    long m_tick {0};
+
+    std::int64_t m_window[PROFILE_PHASES][PROFILE_WINDOW] {};
+    long m_window_ticks {0};
+
+    SampleRing m_ring;
+    long m_dropped {0};
+
+    std::FILE* m_csv {nullptr};
+    std::FILE* m_trace {nullptr};
+    std::thread m_writer;
+    std::atomic<bool> m_stop {false};
+
+    void write();                                 //the writer threads loop
+    void write_csv_row(long tick, const std::int64_t* durations);
+    void write_trace_event(const ProfileSample& sample, bool first);
+};
+
+//times the rest of the scope it is declared in
+class ProfileScope
+{
+  public:
+    ProfileScope(Profiler& profiler, ProfilePhase phase)
+      : m_profiler {profiler}, m_phase {phase}, m_start {Profiler::Clock::now()} {}
+
+    ~ProfileScope() { m_profiler.record(m_phase, m_start, Profiler::Clock::now()); }
+
+  private:
+    Profiler& m_profiler;
+    ProfilePhase m_phase;
+    Profiler::Clock::time_point m_start;
+};
+
+//thrown when an export file cant be opened
+class ProfileError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+#define PROFILE_JOIN(a, b) a##b
+#define PROFILE_NAME(line) PROFILE_JOIN(profile_scope_, line)
+#define PROFILE_SCOPE(profiler, phase) ProfileScope PROFILE_NAME(__LINE__) {profiler, phase}
+
+#else
+
+#define PROFILE_SCOPE(profiler, phase) do {} while(false)
+
+#endif
+
+#endif
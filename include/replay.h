@@ -0,0 +1,114 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "backend.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+/*********************************** REPLAY ***********************************/
+// The input of every tick of a run, with a hash of the game state after it.
+//
+// A replay file holds:
+//  -a header: magic, version, the rng seed, the level checksum and the tick count
+//  -the inputs, run length encoded as (input, run length) varint pairs,
+//   since most ticks have no input
+//  -one 32 bit state hash per tick
+//
+// Feeding the inputs back through a game with the same seed and level has to
+// produce the same hash after every tick, or the game isnt deterministic.
+/********************************************************************************/
+constexpr char REPLAY_MAGIC[8] {'P','A','C','R','E','P','L','Y'};
+constexpr std::uint32_t REPLAY_VERSION {1};
+
+class Replay
+{
+  public:
+    Replay(std::uint64_t seed, std::uint64_t level_checksum);
+
+    static Replay load(const std::string& file);    //throws ReplayError on failure
+    void save(const std::string& file) const;       //throws ReplayError on failure
+
+    std::uint64_t seed() const;
+    std::uint64_t level_checksum() const;
+    long ticks() const;
+
+    int input(long tick) const;
+    std::uint32_t hash(long tick) const;
+
+    void add(int input, std::uint32_t hash);        //record one more tick
+
+  private:
+    std::uint64_t m_seed;
+    std::uint64_t m_level_checksum;
+    std::vector<int> m_inputs;
+    std::vector<std::uint32_t> m_hashes;
+};
+
+//thrown when a replay file cant be read or written
+class ReplayError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/****************************** RECORDINGBACKEND *******************************/
+// Wraps another backend and records the input and state hash of every tick
+// into a replay.
+/********************************************************************************/
+class RecordingBackend : public Backend
+{
+  public:
+    RecordingBackend(Backend& backend, Replay& replay);
+
+    void attach(GameCore& core) override;
+    int get_input(InputMode input_mode) override;
+    void draw_frame(const Game& game) override;
+    void show_message(const std::string& text) override;
+    void pause(int n_milliseconds) override;
+    void end_tick(const Game& game) override;
+
+  private:
+    Backend& m_backend;
+    Replay& m_replay;
+    int m_tick_input {0};   //input the current tick is running with
+};
+
+/******************************* REPLAYBACKEND ********************************/
+// Wraps another backend and feeds the game the inputs of a replay, checking
+// the state hash after every tick.
+//
+// The game is played again after a game over as long as there are ticks left
+// to replay. The replay stops at its last tick, at the first tick whose hash
+// doesnt match, or when the wrapped backend reads a QUIT.
+/********************************************************************************/
+class ReplayBackend : public Backend
+{
+  public:
+    ReplayBackend(Backend& backend, const Replay& replay);
+
+    void attach(GameCore& core) override;
+    int get_input(InputMode input_mode) override;
+    void draw_frame(const Game& game) override;
+    void show_message(const std::string& text) override;
+    void pause(int n_milliseconds) override;
+    void end_tick(const Game& game) override;
+
+    long ticks_checked() const;
+    bool diverged() const;
+    long diverged_tick() const;     //first tick whose hash didnt match
+    std::uint32_t diverged_hash() const;
+
+  private:
+    Backend& m_backend;
+    const Replay& m_replay;
+    long m_tick {0};
+    long m_diverged_tick {-1};
+    std::uint32_t m_diverged_hash {0};
+
+    bool finished() const;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+/************************************ RNG *************************************/
+// A small, fast, seedable random number generator (xoshiro256**).
+//
+// Each game owns its own Rng, so games never share random state, can run on
+// separate threads, and replay exactly from the same seed.
+/********************************************************************************/
+class Rng
+{
+  public:
+    explicit Rng(std::uint64_t seed);
+
+    std::uint64_t seed() const;     //the seed the generator started from
+
+    std::uint64_t next();           //next 64 random bits
+    int below(int n);               //random int in [0, n), n must be > 0
+
+  private:
+    std::uint64_t m_seed;
+    std::uint64_t m_state[4];
+};
+
+#endif
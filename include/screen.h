@@ -3,33 +3,80 @@
 
 #include "pieces.h"
 #include "coord.h"
+#include "config.h"
+#include "backend.h"
+#include "profile.h"
 
 #include <vector>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
 #include <ncurses.h>
+#include <termios.h>
+
+class Histogram;    //forward declarations from metrics.h
+struct Metrics;
 
 /************************************ Screen ************************************/
 // The screen class is a wrapper around ncurses that we use to:
 //  - initialize the ncurses stdscrn
 //  - get user input (blocking and non_blocking modes)
+//  - send every window staged since the last update to the terminal in one go
+//
+// Given a histogram, the screen records how many bytes each frame writes to
+// the terminal. ncurses writes straight to the fd of the stream it is given, so
+// a FILE that counts in its write callback never sees the output. The stream is
+// a pipe instead, and a relay thread copies it on to the terminal, counting the
+// bytes with an atomic add. Each update records what was relayed since the one
+// before: the last frame and what ncurses wrote checking for input after it.
+// The game thread only writes to the pipe, where it wrote to the terminal before.
+//
+// ncurses can't set terminal modes or read the terminal size through a pipe,
+// so the screen sets the modes on the terminal itself, and hands ncurses the
+// size on start and on every KEY_RESIZE. The relay keeps emptying the pipe if
+// the terminal goes away, so ncurses never blocks on it.
 /********************************************************************************/
 
-enum class InputMode {non_block, block};
-
 class Screen
 {
   public:
-    Screen();
+    explicit Screen(Histogram* write_sizes = nullptr);
     ~Screen();
 
+    Screen(const Screen&) = delete;
+    Screen& operator=(const Screen&) = delete;
+
     int get_ch(InputMode input_mode = InputMode::block);
+    void update();    //flush all staged windows to the terminal
+
+  private:
+    Histogram* m_write_sizes;         //bytes per frame, if measured
+
+    //the output pipe, when measuring
+    SCREEN* m_screen {nullptr};
+    std::FILE* m_output {nullptr};    //write end of the pipe, ncurses writes here
+    int m_relay_fd {-1};              //read end of the pipe
+    std::thread m_relay;
+    std::atomic<std::uint64_t> m_relayed {0};   //bytes the relay copied to the terminal
+    std::uint64_t m_recorded {0};               //m_relayed at the last update
+    termios m_saved_modes {};
+    bool m_modes_saved {false};
+
+    void start_relay();
+    void fit_terminal();              //give ncurses the terminal size, it cant ask the pipe
+    void relay();                     //copy the pipe to the terminal until ncurses closes it
 };
 
 /************************************ Window ************************************/
 // The window class is used to:
 //  -create and initialize an ncurses subwindow on the stdscrn
+//  -move and resize it, when the maze or the terminal changes size
 //  -provide a virtual print() interface for its children
 //
+// print() only stages the window, nothing reaches the terminal until Screen::update().
+//
 // This class is the abstract base class for all window sub_types.
 /********************************************************************************/
 
@@ -40,6 +87,10 @@ class Window
 
     virtual void print() = 0;
 
+    //resize and move the window, returns false if it was already there
+    bool place(int height, int length, Coord stdscr_location);
+    void touch();     //send the whole window to the terminal on its next refresh
+
   protected:
     Window(int height, int length, Coord stdscr_location);
 
@@ -56,6 +107,15 @@ class Window
 // This class can:
 //   -add pieces to background, midground or foreground layers
 //   -print all three layers to the screen (background in the back, foreground on top)
+//   -scroll over a maze larger than itself, following a piece
+//
+// The window is a view onto the maze through a camera, the maze coord shown at
+// its top left. The camera moves when the followed piece gets within a quarter
+// of the window of an edge, and never past the edges of the maze.
+//
+// The background is kept drawn in chunks of the maze. A chunk is only drawn when
+// it first comes into view, or comes into view after a background piece changed,
+// so a frame costs the size of the window however large the maze is.
 /********************************************************************************/
 
 enum class WindowLayer {background, midground, foreground};
@@ -67,11 +127,39 @@ class GameWindow : public Window
 
     void print() override;
     void add(Piece* piece, WindowLayer layer);
+    void clear();                 //remove every piece from every layer
+
+    void show_maze(int width, int height);    //size of the maze the pieces are on, the window size until set
+    void follow(const Piece* piece);          //keep piece in view, nullptr to leave the camera where it is
+    Coord camera() const;
 
   private:
+    //the drawn background of CHUNK_H x CHUNK_W cells of the maze
+    struct Chunk
+    {
+      std::vector<char> cells;    //row major, empty until first drawn
+      unsigned generation {0};    //m_generation when drawn
+    };
+
     std::vector<Piece*> m_background;
     std::vector<Piece*> m_midground;
     std::vector<Piece*> m_foreground;
+
+    std::vector<unsigned> m_background_revisions; //revision of each background piece at the last print
+    bool m_background_stale {true};
+    unsigned m_generation {1};                    //bumped whenever the background changes
+
+    int m_maze_width;
+    int m_maze_height;
+    std::vector<Chunk> m_chunks;                  //row major, covering the maze
+    int m_chunk_cols {0};
+
+    const Piece* m_followed {nullptr};
+    Coord m_camera {0,0};
+
+    bool background_changed();    //true if the background changed since the last print
+    void move_camera();
+    const Chunk& chunk(int col, int row);         //the chunk, drawn again if its out of date
 };
 
 /********************************** TextWindow **********************************/
@@ -94,4 +182,45 @@ class TextWindow : public Window
     std::string m_text;
 };
 
+/******************************** NcursesBackend ********************************/
+// The backend that plays the game on a terminal with ncurses.
+//
+// It owns the screen and the three windows:
+//   -the game window, with pacman and the ghosts in the midground over the maze
+//   -the stats window
+//   -the message window, for the start and game over messages
+//
+// The windows are laid out for the maze on every attach, and again when the
+// terminal is resized. The game window follows pacman over mazes too large for it.
+/********************************************************************************/
+
+class NcursesBackend : public Backend
+{
+  public:
+    explicit NcursesBackend(Metrics* metrics = nullptr);   //measure terminal writes into metrics, if given
+
+    void attach(GameCore& core) override;
+    int get_input(InputMode input_mode) override;
+    void draw_frame(const Game& game) override;
+    void show_message(const std::string& text) override;
+    void pause(int n_milliseconds) override;
+
+  private:
+    Screen m_scrn;              //main ncurses screen
+    GameWindow m_game_win;      //game window, where game is played
+    TextWindow m_stat_win;      //stats window, where stats are printed
+    TextWindow m_message_win;   //message window, where start and game over messages are printed
+
+    int m_maze_width {Dimensions::GAME_SCR_MIN_W};    //size of the attached cores maze
+    int m_maze_height {Dimensions::GAME_SCR_MIN_H};
+
+    void layout();              //size and place the windows for the maze and the terminal
+    void print_stats(const Game& game);
+
+#ifdef PACMAN_PROFILE
+    bool m_show_profile {false};    //show phase timings in the stats window instead of the stats
+    std::string profile_overlay(const Profiler& profiler);
+#endif
+};
+
 #endif
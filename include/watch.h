@@ -0,0 +1,79 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "level.h"
+#include "pack.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+
+//a maze reloaded from its edited files, or why it couldnt be
+struct LevelReload
+{
+  int maze;
+  SharedLevel level;        //nullptr if the files didnt load
+  std::string error;        //the LevelError if they didnt
+};
+
+/******************************** LEVELWATCHER *********************************/
+// Watches the files of a LevelPacks mazes with inotify, and reloads a maze on
+// its own thread when one of them is saved.
+//
+// It watches the directories the files are in rather than the files, so it
+// also sees editors that save by renaming a new file over the old one. Changes
+// are gathered for a moment before reloading, so saving both of a levels files
+// reloads it once.
+//
+// Reloads go on a lock-free list. take() empties it with one atomic exchange,
+// so the game can check for reloads every tick without ever waiting.
+/********************************************************************************/
+class LevelWatcher
+{
+  public:
+    explicit LevelWatcher(std::shared_ptr<LevelPack> levels);   //throws WatchError
+    ~LevelWatcher();
+
+    LevelWatcher(const LevelWatcher&) = delete;
+    LevelWatcher& operator=(const LevelWatcher&) = delete;
+
+    std::vector<LevelReload> take();    //the reloads since the last take, newest first
+
+  private:
+    //a file a maze is loaded from
+    struct WatchedFile
+    {
+      int watch;                //inotify watch of its directory
+      std::string name;         //name in the directory
+      int maze;
+    };
+
+    struct Node
+    {
+      LevelReload reload;
+      Node* next;
+    };
+
+    std::shared_ptr<LevelPack> m_levels;
+    std::vector<WatchedFile> m_files;
+    int m_inotify {-1};
+    std::atomic<Node*> m_reloads {nullptr};     //newest first
+    std::atomic<bool> m_stop {false};
+    std::thread m_thread;
+
+    void watch();                               //the watcher threads loop
+    void read_events(std::vector<bool>& changed);
+    void push(LevelReload reload);
+};
+
+//thrown when the level files cant be watched
+class WatchError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "agent.h"
+#include "core.h"
+#include "pieces.h"
+#include "level.h"
+#include "grid.h"
+#include "config.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace
+{
+  //the key each action presses
+  constexpr int ACTION_INPUTS[] {Inputs::NO_INPUT, Inputs::UP, Inputs::DOWN, Inputs::LEFT, Inputs::RIGHT};
+
+  constexpr std::uint8_t WALL_BORDER {1};
+  constexpr std::uint8_t WALL_INVISIBLE {2};
+
+  //the plane a kind of ghost is shown in
+  ObservationPlane ghost_plane(GhostKind kind)
+  {
+    return static_cast<ObservationPlane>(static_cast<int>(ObservationPlane::blinky) + static_cast<int>(kind));
+  }
+
+  static_assert(static_cast<int>(ObservationPlane::inky) - static_cast<int>(ObservationPlane::blinky) + 1 == GHOST_KINDS,
+                "every kind of ghost needs a plane");
+}
+
+AgentEnv::AgentEnv(SharedLevel level, std::uint64_t seed)
+  :
+  m_level {std::move(level)},
+  m_planes(static_cast<std::size_t>(OBSERVATION_PLANES) * m_level->width() * m_level->height(), 0)
+{
+  fill_maze_planes();
+  reset(seed);
+}
+
+void AgentEnv::reset(std::uint64_t seed)
+{
+  m_core.emplace(m_level, seed);
+  m_done = false;
+  m_steps = 0;
+
+  fill_scoring_planes();
+
+  //clear the actors from wherever the last game left them
+  std::uint8_t* actors = plane(ObservationPlane::pacman);
+  std::fill(actors, plane(ObservationPlane::inky) + m_level->width() * m_level->height(), 0);
+  m_actor_cells.assign(1 + m_core->ghost_count(), Coord{-1, -1});
+  update_actor_planes();
+}
+
+AgentStep AgentEnv::step(Action action)
+{
+  if(m_done)
+    return AgentStep {0, true};
+
+  GameCore& core = *m_core;
+  int points = core.pacman().points();
+
+  //the same phases as Game::game_loop
+  core.pacman_phase(ACTION_INPUTS[static_cast<int>(action)]);
+  core.ghost_phase();
+  core.score_phase();
+
+  if(core.point_scored())
+    clear_cell(ObservationPlane::points, core.pacman().location());
+  if(core.power_up_scored())
+    clear_cell(ObservationPlane::power_ups, core.pacman().location());
+
+  m_done = core.game_over();
+
+  if(!m_done) {
+    if(core.level_cleared()) {
+      core.next_level();
+      fill_scoring_planes();
+    }
+
+    if(core.pacman_eaten())
+      core.reset_positions();
+
+    core.end_phase();
+  }
+
+  update_actor_planes();
+  m_steps++;
+
+  return AgentStep {core.pacman().points() - points, m_done};
+}
+
+Observation AgentEnv::observation() const
+{
+  return Observation {m_planes.data(), m_level->width(), m_level->height()};
+}
+
+bool AgentEnv::done() const { return m_done; }
+
+long AgentEnv::steps() const { return m_steps; }
+
+const GameCore& AgentEnv::core() const { return *m_core; }
+
+/********************************** PLANES ***********************************/
+
+std::uint8_t* AgentEnv::plane(ObservationPlane p)
+{
+  return m_planes.data() + static_cast<int>(p) * m_level->width() * m_level->height();
+}
+
+bool AgentEnv::in_bounds(Coord coord) const
+{
+  return coord.x >= 0 && coord.x < m_level->width() && coord.y >= 0 && coord.y < m_level->height();
+}
+
+void AgentEnv::fill_maze_planes()
+{
+  TileGrid grid = m_level->grid();
+  std::uint8_t* walls = plane(ObservationPlane::walls);
+
+  grid.for_each(Tile::BORDER | Tile::INV_WALL, [&](Coord c) {
+    walls[c.y * m_level->width() + c.x] = grid.is_border(c) ? WALL_BORDER : WALL_INVISIBLE;
+  });
+}
+
+void AgentEnv::fill_scoring_planes()
+{
+  TileGrid grid = m_level->grid();
+  std::uint8_t* points = plane(ObservationPlane::points);
+  std::uint8_t* power_ups = plane(ObservationPlane::power_ups);
+
+  grid.for_each(Tile::POINT | Tile::POWER_UP, [&](Coord c) {
+    int index = c.y * m_level->width() + c.x;
+    points[index] = (grid.at(c) & Tile::POINT) != 0;
+    power_ups[index] = (grid.at(c) & Tile::POWER_UP) != 0;
+  });
+}
+
+void AgentEnv::clear_cell(ObservationPlane p, Coord coord)
+{
+  if(in_bounds(coord))
+    plane(p)[coord.y * m_level->width() + coord.x] = 0;
+}
+
+void AgentEnv::update_actor_planes()
+{
+  const GameCore& core = *m_core;
+
+  //ghosts of a kind share a plane, so clear every old cell before drawing any new one
+  clear_cell(ObservationPlane::pacman, m_actor_cells[0]);
+  for(int n = 0; n < core.ghost_count(); n++) {
+    clear_cell(ghost_plane(core.ghost(n).kind()), m_actor_cells[n + 1]);
+  }
+
+  auto draw = [this](ObservationPlane p, Coord cell, std::uint8_t value) {
+    if(in_bounds(cell))
+      plane(p)[cell.y * m_level->width() + cell.x] = value;
+  };
+
+  m_actor_cells[0] = core.pacman().location();
+  draw(ObservationPlane::pacman, m_actor_cells[0], 1);
+
+  for(int n = 0; n < core.ghost_count(); n++) {
+    const Ghost& ghost = core.ghost(n);
+    m_actor_cells[n + 1] = ghost.location();
+    draw(ghost_plane(ghost.kind()), m_actor_cells[n + 1], 1 + static_cast<int>(ghost.state()));
+  }
+}
@@ -0,0 +1,27 @@
+#include "backend.h"
+#include "config.h"
+
+#include <string>
+
+using std::string;
+
+/*********************************** BACKEND ***********************************/
+
+void Backend::end_tick(const Game&) {}
+
+/********************************* NULLBACKEND *********************************/
+
+void NullBackend::attach(GameCore&) {}
+
+int NullBackend::get_input(InputMode input_mode)
+{
+  if(input_mode == InputMode::block)
+    return Inputs::PLAY;    //always start and play again
+  return Inputs::NO_INPUT;
+}
+
+void NullBackend::draw_frame(const Game&) {}
+
+void NullBackend::show_message(const string&) {}
+
+void NullBackend::pause(int) {}
@@ -0,0 +1,655 @@
+#include "batch.h"
+#include "core.h"
+#include "pieces.h"
+#include "ghosts.h"
+#include "level.h"
+#include "config.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using std::vector;
+using std::uint8_t;
+using std::uint64_t;
+
+namespace
+{
+  //the ghost moves, in the order calc_ghost_destination tries them
+  enum Move : uint8_t {move_right, move_down, move_left, move_up, move_none};
+
+  constexpr int MOVES {4};
+  constexpr int MOVE_DX[MOVES] {2, 0, -2, 0};
+  constexpr int MOVE_DY[MOVES] {0, 1, 0, -1};
+  constexpr Momentum MOVE_MOMENTUM[MOVES] {Momentum::right, Momentum::down, Momentum::left, Momentum::up};
+
+  constexpr uint8_t state_of(GhostState state) { return static_cast<uint8_t>(state); }
+
+  constexpr uint8_t CHASE {state_of(GhostState::chase)};
+  constexpr uint8_t SCATTER {state_of(GhostState::scatter)};
+  constexpr uint8_t TURN_AROUND {state_of(GhostState::turn_around)};
+  constexpr uint8_t FRIGHTENED {state_of(GhostState::frightened)};
+  constexpr uint8_t EATEN {state_of(GhostState::eaten)};
+
+  constexpr uint8_t PURSUIT_CHASE {static_cast<uint8_t>(PursuitState::chase)};
+  constexpr uint8_t PURSUIT_SCATTER {static_cast<uint8_t>(PursuitState::scatter)};
+
+  //the ghost state a pursuit state puts a ghost in
+  uint8_t pursuit_ghost_state(uint8_t pursuit_state)
+  {
+    return pursuit_state == PURSUIT_CHASE ? CHASE : SCATTER;
+  }
+}
+
+BatchEngine::BatchEngine(SharedLevel level, const vector<uint64_t>& seeds)
+  :
+  m_maze {level},
+  m_grid {level->grid()},
+  m_nav {level->nav()},
+  m_junctions {&level->junctions()},
+  m_start_points {level->points()},
+  m_start_power_ups {level->power_ups()},
+  m_point_count {level->point_count()},
+  m_power_up_count {level->power_up_count()},
+  m_pacman_home {level->locations().pacman_start},
+  m_ghosts {level->ghost_count()},
+  m_left_warp {level->locations().left_warp},
+  m_right_warp {level->locations().right_warp},
+  m_words {static_cast<int>(bitset_words(level->width(), level->height()))},
+  m_size {static_cast<int>(seeds.size())},
+  m_pac_x(m_size, m_pacman_home.x),
+  m_pac_y(m_size, m_pacman_home.y),
+  m_pac_momentum(m_size, Momentum::left),
+  m_pac_lives(m_size, GameConfig::PACMAN_START_LIVES),
+  m_pac_points(m_size, GameConfig::PACMAN_START_POINTS),
+  m_pac_eaten(m_size, 0),
+  m_points(static_cast<std::size_t>(m_size) * m_words),
+  m_power_ups(static_cast<std::size_t>(m_size) * m_words),
+  m_points_remaining(m_size, m_point_count),
+  m_power_ups_remaining(m_size, m_power_up_count),
+  m_points_scored(m_size, 0),
+  m_power_up_scored(m_size, 0),
+  m_power_up_active(m_size, 0),
+  m_power_up_timer(m_size, 0),
+  m_pursuit_timer(m_size, 0),
+  m_blink_timer(m_size, 0),
+  m_pursuit_state(m_size, PURSUIT_SCATTER),
+  m_level(m_size, GameConfig::STARTING_LEVEL),
+  m_games_played(m_size, 0),
+  m_moving(m_size, 0),
+  m_target_x(m_size, 0),
+  m_target_y(m_size, 0),
+  m_forced(m_size, move_none),
+  m_destination(m_size, move_none)
+{
+  for(int ghost = 0; ghost < m_ghosts; ghost++) {
+    const LevelGhost& start = level->ghost(ghost);
+    m_ghost_home.push_back(start.start);
+    m_ghost_scatter.push_back(start.scatter);
+
+    m_ghost_x.emplace_back(m_size, start.start.x);
+    m_ghost_y.emplace_back(m_size, start.start.y);
+    m_ghost_momentum.emplace_back(m_size, Momentum::still);
+    m_ghost_state.emplace_back(m_size, SCATTER);
+    m_ghost_eaten.emplace_back(m_size, 0);
+  }
+
+  for(int kind = 0; kind < GHOST_KINDS; kind++) {
+    m_kinds[kind] = level->ghosts(static_cast<GhostKind>(kind));
+  }
+
+  const GhostRange& blinkies = m_kinds[static_cast<int>(GhostKind::blinky)];
+  m_partner = blinkies.first < blinkies.last ? blinkies.first : -1;
+
+  for(int move = 0; move < MOVES; move++) {
+    m_valid[move].assign(m_size, 0);
+    m_distance[move].assign(m_size, 0);
+  }
+
+  m_rngs.reserve(m_size);
+  for(int game = 0; game < m_size; game++) {
+    std::memcpy(&m_points[game * m_words], m_start_points.words, m_words * sizeof(uint64_t));
+    std::memcpy(&m_power_ups[game * m_words], m_start_power_ups.words, m_words * sizeof(uint64_t));
+    m_rngs.emplace_back(seeds[game]);
+  }
+}
+
+int BatchEngine::size() const { return m_size; }
+
+long BatchEngine::ticks() const { return m_ticks; }
+
+void BatchEngine::step(const int* inputs)
+{
+  pacman_phase(inputs);
+  ghost_phase();
+  score_phase();
+  reset_phase();
+  end_phase();
+
+  m_ticks++;
+}
+
+/********************************** GETTERS **********************************/
+
+std::uint32_t BatchEngine::state_hash(int game) const
+{
+  StateHash hash;
+
+  hash.add(m_pac_x[game]);
+  hash.add(m_pac_y[game]);
+  hash.add(m_pac_momentum[game]);
+  hash.add(m_pac_lives[game]);
+  hash.add(m_pac_points[game]);
+
+  for(int ghost = 0; ghost < m_ghosts; ghost++) {
+    hash.add(m_ghost_x[ghost][game]);
+    hash.add(m_ghost_y[ghost][game]);
+    hash.add(m_ghost_momentum[ghost][game]);
+    hash.add(m_ghost_state[ghost][game]);
+  }
+
+  hash.add(m_power_up_timer[game]);
+  hash.add(m_pursuit_timer[game]);
+  hash.add(m_blink_timer[game]);
+  hash.add(m_pursuit_state[game]);
+  hash.add(m_power_up_active[game]);
+  hash.add(m_points_remaining[game]);
+  hash.add(m_power_ups_remaining[game]);
+  hash.add(m_level[game]);
+
+  return hash.value();
+}
+
+int BatchEngine::score(int game) const { return m_pac_points[game]; }
+
+int BatchEngine::lives(int game) const { return m_pac_lives[game]; }
+
+int BatchEngine::level(int game) const { return m_level[game]; }
+
+int BatchEngine::games_played(int game) const { return m_games_played[game]; }
+
+int BatchEngine::points_remaining(int game) const { return m_points_remaining[game]; }
+
+Coord BatchEngine::pacman_location(int game) const { return Coord{m_pac_x[game], m_pac_y[game]}; }
+
+uint64_t BatchEngine::seed(int game) const { return m_rngs[game].seed(); }
+
+int BatchEngine::ghost_count() const { return m_ghosts; }
+
+/******************************** TICK PHASES ********************************/
+
+void BatchEngine::pacman_phase(const int* inputs)
+{
+  for(int game = 0; game < m_size; game++) {
+    int& x = m_pac_x[game];
+    int& y = m_pac_y[game];
+
+    //the input direction if it has no wall, else keep moving with momentum
+    int move {move_none};
+    switch(inputs[game]) {
+      case Inputs::RIGHT: move = move_right; break;
+      case Inputs::DOWN:  move = move_down;  break;
+      case Inputs::LEFT:  move = move_left;  break;
+      case Inputs::UP:    move = move_up;    break;
+      default: break;
+    }
+
+    if(move == move_none || m_grid.is_wall(Coord{x + MOVE_DX[move], y + MOVE_DY[move]})) {
+      switch(m_pac_momentum[game]) {
+        case Momentum::right: move = move_right; break;
+        case Momentum::down:  move = move_down;  break;
+        case Momentum::left:  move = move_left;  break;
+        case Momentum::up:    move = move_up;    break;
+        default:              move = move_none;  break;
+      }
+      if(move != move_none && m_grid.is_wall(Coord{x + MOVE_DX[move], y + MOVE_DY[move]}))
+        move = move_none;
+    }
+
+    if(move != move_none) {
+      x += MOVE_DX[move];
+      y += MOVE_DY[move];
+      m_pac_momentum[game] = MOVE_MOMENTUM[move];
+    }
+
+    take_warp(x, y);
+
+    check_pacman_eaten(game);
+    check_ghosts_eaten(game);
+  }
+}
+
+void BatchEngine::ghost_phase()
+{
+  for(int game = 0; game < m_size; game++) {
+    m_moving[game] = !m_pac_eaten[game];    //dont move ghosts if pacman was eaten
+  }
+
+  //each ghost moves in turn, a kind at a time, so inky targets off where blinky moved to
+  for_each_ghost_kind([this](auto kind) {
+    constexpr GhostKind KIND = decltype(kind)::value;
+    const GhostRange& range = m_kinds[static_cast<int>(KIND)];
+
+    for(int ghost = range.first; ghost < range.last; ghost++) {
+      ghost_targets<GhostPolicy<KIND>>(ghost);
+      ghost_destinations(ghost);
+      move_ghosts(ghost);
+    }
+  });
+
+  for(int game = 0; game < m_size; game++) {
+    if(m_moving[game]) {
+      check_pacman_eaten(game);
+      check_ghosts_eaten(game);
+    }
+  }
+}
+
+void BatchEngine::score_phase()
+{
+  for(int game = 0; game < m_size; game++) {
+    //check scores, only if pacman wasnt eaten
+    if(!m_pac_eaten[game]) {
+      m_points_scored[game] = take_cell(m_points, game, m_pac_x[game], m_pac_y[game]);
+      m_power_up_scored[game] = take_cell(m_power_ups, game, m_pac_x[game], m_pac_y[game]);
+      m_points_remaining[game] -= m_points_scored[game];
+      m_power_ups_remaining[game] -= m_power_up_scored[game];
+    }
+
+    //pacmans score
+    int ghosts_eaten {0};
+    for(int ghost = 0; ghost < m_ghosts; ghost++) {
+      ghosts_eaten += m_ghost_eaten[ghost][game];
+    }
+    m_pac_points[game] += m_points_scored[game] * GameConfig::POINT_VALUE
+                          + m_power_up_scored[game] * GameConfig::POWER_UP_VALUE
+                          + ghosts_eaten * GameConfig::GHOST_VALUE;
+  }
+
+  //power up state
+  for(int game = 0; game < m_size; game++) {
+    if(m_power_up_scored[game]) {
+      m_power_up_timer[game] = GameConfig::POWER_UP_LENGTH;
+      m_power_up_active[game] = 1;
+    } else if(m_power_up_active[game]) {
+      if(m_power_up_timer[game] <= 0)
+        m_power_up_active[game] = 0;
+      else
+        m_power_up_timer[game]--;
+    }
+  }
+
+  //ghost states, with the pursuit state from before this tick
+  for(int ghost = 0; ghost < m_ghosts; ghost++) {
+    for(int game = 0; game < m_size; game++) {
+      uint8_t& state = m_ghost_state[ghost][game];
+      uint8_t pursuit = pursuit_ghost_state(m_pursuit_state[game]);
+      bool eaten = m_ghost_eaten[ghost][game];
+
+      if(state == CHASE || state == SCATTER) {
+        state = m_power_up_scored[game] ? TURN_AROUND : pursuit;
+      } else if(state == TURN_AROUND) {
+        state = eaten ? EATEN : FRIGHTENED;
+      } else if(state == FRIGHTENED) {
+        state = eaten ? EATEN : (m_power_up_active[game] ? FRIGHTENED : pursuit);
+      } else {
+        bool home = m_ghost_x[ghost][game] == m_ghost_home[ghost].x && m_ghost_y[ghost][game] == m_ghost_home[ghost].y;
+        state = home ? pursuit : EATEN;
+      }
+    }
+  }
+
+  //pursuit state
+  for(int game = 0; game < m_size; game++) {
+    int length = m_pursuit_state[game] == PURSUIT_CHASE ? GameConfig::CHASE_LENGTH : GameConfig::SCATTER_LENGTH;
+    if(m_pursuit_timer[game] == length) {
+      m_pursuit_state[game] = m_pursuit_state[game] == PURSUIT_CHASE ? PURSUIT_SCATTER : PURSUIT_CHASE;
+      m_pursuit_timer[game] = 0;
+    } else {
+      m_pursuit_timer[game]++;
+    }
+  }
+}
+
+void BatchEngine::reset_phase()
+{
+  for(int game = 0; game < m_size; game++) {
+    if(m_pac_lives[game] <= 0) {        //game over, always play again
+      m_games_played[game]++;
+      reset_game(game);
+    }
+
+    if(m_points_remaining[game] == 0)   //level cleared
+      next_level(game);
+
+    if(m_pac_eaten[game])               //pacman was eaten
+      reset_positions(game);
+  }
+}
+
+void BatchEngine::end_phase()
+{
+  std::fill(m_pac_eaten.begin(), m_pac_eaten.end(), 0);
+  for(vector<uint8_t>& eaten : m_ghost_eaten) {
+    std::fill(eaten.begin(), eaten.end(), 0);
+  }
+  std::fill(m_points_scored.begin(), m_points_scored.end(), 0);
+  std::fill(m_power_up_scored.begin(), m_power_up_scored.end(), 0);
+
+  for(int game = 0; game < m_size; game++) {
+    int& timer = m_blink_timer[game];
+    timer = timer <= 0 ? GameConfig::POWER_UP_BLINK_LENGTH : timer - 1;
+  }
+}
+
+/******************************** GHOST PHASE ********************************/
+
+template<typename Policy>
+void BatchEngine::ghost_targets(int ghost)
+{
+  const vector<int>& ghost_x = m_ghost_x[ghost];
+  const vector<int>& ghost_y = m_ghost_y[ghost];
+
+  for(int game = 0; game < m_size; game++) {
+    if(!m_moving[game])
+      continue;
+
+    Coord target {ghost_x[game], ghost_y[game]};
+
+    switch(m_ghost_state[ghost][game]) {
+      case CHASE:
+      {
+        Coord partner = m_partner >= 0 ? Coord{m_ghost_x[m_partner][game], m_ghost_y[m_partner][game]} : Coord{0,0};
+        ChaseView view {Coord{m_pac_x[game], m_pac_y[game]}, two_infront_of_pacman(game), partner, m_nav};
+        target = Policy::target(target, m_ghost_scatter[ghost], view);
+        break;
+      }
+      case SCATTER:
+      {
+        target = m_ghost_scatter[ghost];
+        break;
+      }
+      case EATEN:
+      {
+        target = m_ghost_home[ghost];
+        break;
+      }
+      case FRIGHTENED:
+      {
+        switch(m_rngs[game].below(4)) {   //the same draw GameCore::random_target makes
+          case 0: target = target + Coord{0,-1}; break;
+          case 1: target = target + Coord{0,1};  break;
+          case 2: target = target + Coord{-2,0}; break;
+          case 3: target = target + Coord{2,0};  break;
+        }
+        break;
+      }
+      case TURN_AROUND:
+      {
+        switch(m_ghost_momentum[ghost][game]) {
+          case Momentum::up:    target = target + Coord{0,1};  break;
+          case Momentum::down:  target = target + Coord{0,-1}; break;
+          case Momentum::left:  target = target + Coord{2,0};  break;
+          case Momentum::right: target = target + Coord{-2,0}; break;
+          default: break;
+        }
+        break;
+      }
+    }
+
+    m_target_x[game] = target.x;
+    m_target_y[game] = target.y;
+  }
+}
+
+void BatchEngine::ghost_destinations(int ghost)
+{
+  const vector<int>& ghost_x = m_ghost_x[ghost];
+  const vector<int>& ghost_y = m_ghost_y[ghost];
+  const vector<uint8_t>& momentum = m_ghost_momentum[ghost];
+  const vector<uint8_t>& state = m_ghost_state[ghost];
+
+  //the forced move in a corridor, else the validity and distance of each candidate move
+  for(int game = 0; game < m_size; game++) {
+    m_forced[game] = move_none;
+    for(int move = 0; move < MOVES; move++) {
+      m_valid[move][game] = 0;
+    }
+
+    if(!m_moving[game])
+      continue;
+
+    Coord location {ghost_x[game], ghost_y[game]};
+    bool turn_around = state[game] == TURN_AROUND;
+    bool eaten = state[game] == EATEN;
+
+    if(!turn_around && momentum[game] != Momentum::still) {
+      NavMove heading = momentum[game] == Momentum::right ? NavMove::right
+                      : momentum[game] == Momentum::down  ? NavMove::down
+                      : momentum[game] == Momentum::left  ? NavMove::left
+                      : NavMove::up;
+      NavMove forced = m_junctions->corridor_move(location, heading);
+      if(forced != NavMove::none) {
+        m_forced[game] = static_cast<uint8_t>(forced);
+        continue;
+      }
+    }
+
+    Coord target {m_target_x[game], m_target_y[game]};
+    const std::uint16_t* field = m_nav.field(target, eaten ? NavRules::eaten : NavRules::normal);
+
+    //cant go back the way it came unless turning around
+    constexpr Momentum BACK[MOVES] {Momentum::left, Momentum::up, Momentum::right, Momentum::down};
+
+    for(int move = 0; move < MOVES; move++) {
+      Coord next {location.x + MOVE_DX[move], location.y + MOVE_DY[move]};
+      bool through_inv_wall = move == move_up || (move == move_down && eaten);
+
+      m_valid[move][game] = (momentum[game] != BACK[move] || turn_around)
+                            && !m_grid.is_border(next)
+                            && (!m_grid.is_inv_wall(next) || through_inv_wall);
+      m_distance[move][game] = field ? m_nav.distance(field, next)
+                                     : scaled_distance(next, target);
+    }
+  }
+
+  //pick the valid move with the least distance, the last one tried wins a tie
+  for(int game = 0; game < m_size; game++) {
+    int best = std::numeric_limits<int>::max();
+    uint8_t destination = move_none;
+
+    for(int move = 0; move < MOVES; move++) {
+      bool take = m_valid[move][game] && m_distance[move][game] <= best;
+      best = take ? m_distance[move][game] : best;
+      destination = take ? move : destination;
+    }
+
+    m_destination[game] = m_forced[game] != move_none ? m_forced[game] : destination;
+  }
+
+  //a ghost boxed in on three sides can turn around into the fourth
+  for(int game = 0; game < m_size; game++) {
+    if(!m_moving[game] || m_destination[game] != move_none)
+      continue;
+
+    Coord location {ghost_x[game], ghost_y[game]};
+    bool right = m_grid.is_border(location + Coord{2,0});
+    bool down = m_grid.is_border(location + Coord{0,1});
+    bool left = m_grid.is_border(location + Coord{-2,0});
+    bool up = m_grid.is_border(location + Coord{0,-1});
+
+    if(left && right && up) {
+      if(!down)
+        m_destination[game] = move_down;
+    } else if(left && right && down) {
+      if(!up)
+        m_destination[game] = move_up;
+    } else if(left && up && down) {
+      if(!right)
+        m_destination[game] = move_right;
+    } else if(right && up && down) {
+      if(!left)
+        m_destination[game] = move_left;
+    }
+  }
+}
+
+void BatchEngine::move_ghosts(int ghost)
+{
+  vector<int>& ghost_x = m_ghost_x[ghost];
+  vector<int>& ghost_y = m_ghost_y[ghost];
+
+  for(int game = 0; game < m_size; game++) {
+    uint8_t move = m_destination[game];
+    if(!m_moving[game] || move == move_none)
+      continue;
+
+    ghost_x[game] += MOVE_DX[move];
+    ghost_y[game] += MOVE_DY[move];
+    m_ghost_momentum[ghost][game] = MOVE_MOMENTUM[move];
+
+    take_warp(ghost_x[game], ghost_y[game]);
+  }
+}
+
+/******************************** COLLISIONS *********************************/
+
+void BatchEngine::check_pacman_eaten(int game)
+{
+  if(m_pac_eaten[game])     //pacman can only be eaten once
+    return;
+
+  for(int ghost = 0; ghost < m_ghosts; ghost++) {
+    uint8_t state = m_ghost_state[ghost][game];
+    if((state == CHASE || state == SCATTER)
+       && m_ghost_x[ghost][game] == m_pac_x[game] && m_ghost_y[ghost][game] == m_pac_y[game]) {
+      m_pac_eaten[game] = 1;
+      m_pac_lives[game]--;
+      return;
+    }
+  }
+}
+
+void BatchEngine::check_ghosts_eaten(int game)
+{
+  if(m_pac_eaten[game])     //cant eat a ghost if pacman is eaten
+    return;
+
+  //in GHOST_EAT_ORDER, once a ghost is eaten the ones after it arent checked, like GameCore::check_ghosts_eaten
+  for(GhostKind kind : GHOST_EAT_ORDER) {
+    const GhostRange& range = m_kinds[static_cast<int>(kind)];
+
+    for(int ghost = range.first; ghost < range.last; ghost++) {
+      if(m_ghost_eaten[ghost][game])
+        continue;
+
+      uint8_t state = m_ghost_state[ghost][game];
+      bool eaten = (state == FRIGHTENED || state == TURN_AROUND)
+                   && m_ghost_x[ghost][game] == m_pac_x[game] && m_ghost_y[ghost][game] == m_pac_y[game];
+      m_ghost_eaten[ghost][game] = eaten;
+      if(eaten)
+        return;
+    }
+  }
+}
+
+/********************************** RESETS ***********************************/
+
+void BatchEngine::reset_positions(int game)
+{
+  m_pac_x[game] = m_pacman_home.x;
+  m_pac_y[game] = m_pacman_home.y;
+  m_pac_momentum[game] = Momentum::left;
+
+  for(int ghost = 0; ghost < m_ghosts; ghost++) {
+    m_ghost_x[ghost][game] = m_ghost_home[ghost].x;
+    m_ghost_y[ghost][game] = m_ghost_home[ghost].y;
+    m_ghost_momentum[ghost][game] = Momentum::still;
+    m_ghost_state[ghost][game] = SCATTER;
+    m_ghost_eaten[ghost][game] = 0;
+  }
+}
+
+void BatchEngine::next_level(int game)
+{
+  m_pac_x[game] = m_pacman_home.x;
+  m_pac_y[game] = m_pacman_home.y;
+  m_pac_momentum[game] = Momentum::left;
+
+  for(int ghost = 0; ghost < m_ghosts; ghost++) {    //ghosts go home but keep their states
+    m_ghost_x[ghost][game] = m_ghost_home[ghost].x;
+    m_ghost_y[ghost][game] = m_ghost_home[ghost].y;
+    m_ghost_momentum[ghost][game] = Momentum::still;
+  }
+
+  std::memcpy(&m_points[game * m_words], m_start_points.words, m_words * sizeof(uint64_t));
+  std::memcpy(&m_power_ups[game * m_words], m_start_power_ups.words, m_words * sizeof(uint64_t));
+  m_points_remaining[game] = m_point_count;
+  m_power_ups_remaining[game] = m_power_up_count;
+  m_points_scored[game] = 0;
+  m_power_up_scored[game] = 0;
+
+  m_level[game]++;
+}
+
+void BatchEngine::reset_game(int game)
+{
+  reset_positions(game);
+  m_pac_lives[game] = GameConfig::PACMAN_START_LIVES;
+  m_pac_points[game] = GameConfig::PACMAN_START_POINTS;
+  m_pac_eaten[game] = 0;
+
+  std::memcpy(&m_points[game * m_words], m_start_points.words, m_words * sizeof(uint64_t));
+  std::memcpy(&m_power_ups[game * m_words], m_start_power_ups.words, m_words * sizeof(uint64_t));
+  m_points_remaining[game] = m_point_count;
+  m_power_ups_remaining[game] = m_power_up_count;
+  m_points_scored[game] = 0;
+  m_power_up_scored[game] = 0;
+
+  m_level[game] = 1;
+
+  m_power_up_timer[game] = 0;       //the power up state itself carries over, as in GameCore::reset_game
+  m_pursuit_timer[game] = 0;
+  m_blink_timer[game] = 0;
+  m_pursuit_state[game] = PURSUIT_SCATTER;
+}
+
+/********************************** HELPERS **********************************/
+
+void BatchEngine::take_warp(int& x, int& y) const
+{
+  if(x == m_left_warp.x && y == m_left_warp.y) {
+    x = m_right_warp.x;
+    y = m_right_warp.y;
+  } else if(x == m_right_warp.x && y == m_right_warp.y) {
+    x = m_left_warp.x;
+    y = m_left_warp.y;
+  }
+}
+
+bool BatchEngine::take_cell(vector<uint64_t>& cells, int game, int x, int y) const
+{
+  if(x < 0 || x >= m_grid.width() || y < 0 || y >= m_grid.height())
+    return false;
+
+  int index = y * m_grid.width() + x;
+  uint64_t& word = cells[static_cast<std::size_t>(game) * m_words + index / 64];
+  uint64_t bit = uint64_t{1} << (index % 64);
+
+  bool taken = word & bit;
+  word &= ~bit;
+  return taken;
+}
+
+Coord BatchEngine::two_infront_of_pacman(int game) const
+{
+  Coord pacman {m_pac_x[game], m_pac_y[game]};
+  switch(m_pac_momentum[game]) {
+    case Momentum::up:    return pacman + Coord{0,-2};
+    case Momentum::down:  return pacman + Coord{0,2};
+    case Momentum::left:  return pacman + Coord{-4,0};    //4 coords over, since pieces move 2 left or right
+    case Momentum::right: return pacman + Coord{4,0};
+    default:              return pacman;
+  }
+}
@@ -0,0 +1,515 @@
+#include "core.h"
+#include "batch.h"
+#include "agent.h"
+#include "pieces.h"
+#include "screen.h"
+#include "level.h"
+#include "grid.h"
+#include "config.h"
+#include "rng.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <ncurses.h>
+
+/*
+ * pacman-bench times the engines hot functions on their own and prints the
+ * results as JSON, one entry per function and maze, with ns/op and allocs/op.
+ *
+ *   make bench
+ *
+ * Every function is timed on the real level 1 maze, on larger synthetic mazes
+ * and on a synthetic maze with 64 ghosts. Rendering goes to a VIEW_H x VIEW_W
+ * ncurses terminal opened on /dev/null, and is also timed on a maze of over a
+ * million cells.
+ *
+ *   make verify
+ *
+ * runs pacman-bench --verify instead, which plays the same games in BatchEngine
+ * and GameCore and exits with 1 at the first tick their state hashes differ.
+ */
+
+using std::string;
+using std::vector;
+
+/****************************** allocation counting ******************************/
+
+namespace
+{
+  long g_allocs {0};    //operator new calls since the program started
+}
+
+void* operator new(std::size_t size)
+{
+  g_allocs++;
+  if(void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+/******************************** GameCoreBench *********************************/
+// Friend of GameCore, so the private movement and collision methods can be timed.
+/********************************************************************************/
+class GameCoreBench
+{
+  public:
+    static int ghost_destination(GameCore& core, Ghost* ghost, Coord target)
+    {
+      return static_cast<int>(core.calc_ghost_destination(ghost, target));
+    }
+
+    //pacman jumps to coord, then both collision checks of a phase, then the flags are cleared
+    static int collisions(GameCore& core, Coord coord)
+    {
+      core.m_pacman.jump(coord);
+      int eaten = core.check_pacman_eaten() + core.check_ghosts_eaten();
+      core.reset_piece_flags();
+      return eaten;
+    }
+};
+
+namespace
+{
+  constexpr double MIN_SECONDS {0.2};     //run each benchmark at least this long
+  constexpr int BATCH_GAMES {64};          //games BatchEngine::step advances at once
+  constexpr int VIEW_H {40};              //the terminal GameWindow::print draws into
+  constexpr int VIEW_W {120};
+  constexpr int VERIFY_GAMES {16};        //games --verify plays side by side on each maze
+  constexpr long VERIFY_TICKS {10000};    //ticks --verify plays each of them for
+
+  struct Result
+  {
+    string name;
+    string maze;
+    long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+  };
+
+  volatile long g_sink {0};     //keeps the timed results from being optimized away
+
+  //run op(i) in growing batches until they take MIN_SECONDS, then report the last batch
+  template<typename Op>
+  Result run(const string& name, const string& maze, Op op)
+  {
+    using clock = std::chrono::steady_clock;
+
+    for(long iterations = 100; ; iterations *= 2) {
+      long sink {0};
+      long allocs_before = g_allocs;
+      auto start = clock::now();
+
+      for(long i = 0; i < iterations; i++) {
+        sink += op(i);
+      }
+
+      std::chrono::duration<double> elapsed = clock::now() - start;
+      long allocs = g_allocs - allocs_before;
+      g_sink = g_sink + sink;
+
+      if(elapsed.count() >= MIN_SECONDS) {
+        std::cerr << "pacman-bench: " << maze << " " << name << "\n";
+        return Result{name, maze, iterations, elapsed.count() * 1e9 / iterations,
+                      static_cast<double>(allocs) / iterations};
+      }
+    }
+  }
+
+  //every cell a piece can stand on
+  vector<Coord> open_cells(const Level& level)
+  {
+    vector<Coord> cells;
+    TileGrid grid = level.grid();
+    for(int y = 0; y < grid.height(); y++) {
+      for(int x = 0; x < grid.width(); x++) {
+        if(!grid.is_wall(Coord{x, y}))
+          cells.push_back(Coord{x, y});
+      }
+    }
+    return cells;
+  }
+
+  //every cell of the level
+  vector<Coord> all_cells(const Level& level)
+  {
+    vector<Coord> cells;
+    for(int y = 0; y < level.height(); y++) {
+      for(int x = 0; x < level.width(); x++) {
+        cells.push_back(Coord{x, y});
+      }
+    }
+    return cells;
+  }
+
+  /*
+   * Build a rows x cols maze in the level text format: a border ring, pillars of
+   * border every few cells, points on the rest, power ups in the corners and
+   * four ghosts lined up in the middle. Any ghosts past four are lined up a few
+   * rows below, cycling through the kinds. Cells are two chars wide like level 1.
+   */
+  Level synthetic_level(int rows, int cols, int ghosts = 4)
+  {
+    const char GHOST_STARTS[] {'B', 'P', 'C', 'I'};
+
+    std::ostringstream shapes;
+    std::ostringstream locations;
+
+    for(int y = 0; y < rows; y++) {
+      string shape_row;
+      string location_row(cols * 2, ' ');
+
+      for(int x = 0; x < cols; x++) {
+        bool edge = y == 0 || y == rows - 1 || x == 0 || x == cols - 1;
+        bool pillar = y % 4 == 2 && x % 4 >= 2;
+        bool corner = (y == 1 || y == rows - 2) && (x == 1 || x == cols - 2);
+
+        if(edge || pillar)
+          shape_row += "##";
+        else if(corner)
+          shape_row += " !";
+        else
+          shape_row += " .";
+      }
+
+      auto place = [&](int row, int col, char symbol) {
+        if(row == y)
+          location_row[col * 2 + 1] = symbol;
+      };
+
+      int middle = (rows / 8) * 4 + 1;    //a row near the middle with no pillars
+      place(rows - 3, cols / 2, '<');
+      place(middle, cols / 2, 'B');
+      place(middle, cols / 2 - 2, 'P');
+      place(middle, cols / 2 + 2, 'I');
+      place(middle, cols / 2 + 4, 'C');
+      place(1, cols - 3, 'b');
+      place(1, 2, 'p');
+      place(rows - 2, cols - 3, 'i');
+      place(rows - 2, 2, 'c');
+      place(middle, 1, 'l');
+      place(middle, cols - 2, 'r');
+
+      for(int n = 4; n < ghosts; n++) {
+        place(middle + 4, 2 + (n - 4) * 2, GHOST_STARTS[n % 4]);
+      }
+
+      //the same row prefix and end marker as the level files, so coords line up
+      shapes << (y ? "\n" : "") << "b" << shape_row << "e";
+      locations << (y ? "\n" : "") << "s" << location_row << "e";
+    }
+
+    return parse_level(locations.str(), shapes.str());
+  }
+
+  void bench_render(const string& maze, const SharedLevel& shared, vector<Result>& results);
+
+  //time every function on one maze
+  void bench_maze(const string& maze, const SharedLevel& shared, bool render, vector<Result>& results)
+  {
+    const Level& level = *shared;
+    GameCore core {shared, 1};
+
+    PacMan pacman {level};
+    Ghost blinky {level.ghost(level.ghosts(GhostKind::blinky).first)};
+    Borders borders {level};
+    Points points {level};
+
+    const vector<Coord> cells = all_cells(level);
+    const vector<Coord> open = open_cells(level);
+
+    //Piece::in(coord), for a grid piece, a scoring piece and a list shaped piece
+    results.push_back(run("Piece::in(Coord)/borders", maze, [&](long i) {
+      return borders.in(cells[i % cells.size()]);
+    }));
+
+    results.push_back(run("Piece::in(Coord)/points", maze, [&](long i) {
+      return points.in(cells[i % cells.size()]);
+    }));
+
+    results.push_back(run("Piece::in(Coord)/ghost", maze, [&](long i) {
+      return blinky.in(cells[i % cells.size()]);
+    }));
+
+    //Piece::in(piece), pacman walking past a ghost
+    results.push_back(run("Piece::in(const Piece*)/pacman-ghost", maze, [&](long i) {
+      pacman.jump(open[i % open.size()]);
+      return pacman.in(&blinky);
+    }));
+
+    //ScoringPiece::check_score, pacman walking every open cell, the points are put back each lap
+    results.push_back(run("ScoringPiece::check_score", maze, [&](long i) {
+      std::size_t n = i % open.size();
+      if(n == 0)
+        points.reset();
+      pacman.jump(open[n]);
+      return points.check_score(&pacman);
+    }));
+
+    //GameCore::calc_ghost_destination, a ghost on every open cell chasing a target on another
+    results.push_back(run("GameCore::calc_ghost_destination", maze, [&](long i) {
+      blinky.jump(open[i % open.size()]);
+      Coord target = open[(i * 7919) % open.size()];
+      return GameCoreBench::ghost_destination(core, &blinky, target);
+    }));
+
+    //GameCore collision checks, pacman walking every open cell past however many ghosts the maze has
+    GameCore colliding {shared, 1};
+
+    results.push_back(run("GameCore::check_pacman_eaten+check_ghosts_eaten", maze, [&](long i) {
+      return GameCoreBench::collisions(colliding, open[i % open.size()]);
+    }));
+
+    const int keys[] {Inputs::UP, Inputs::LEFT, Inputs::DOWN, Inputs::RIGHT, Inputs::NO_INPUT};
+
+    //GameCore tick, the phases and resets of Game::game_loop with a key pressed every few ticks
+    GameCore ticking {shared, 1};
+
+    results.push_back(run("GameCore::tick", maze, [&](long i) {
+      ticking.pacman_phase(keys[(i / 8) % 5]);
+      ticking.ghost_phase();
+      ticking.score_phase();
+      if(ticking.game_over())
+        ticking.reset_game();
+      if(ticking.level_cleared())
+        ticking.next_level();
+      if(ticking.pacman_eaten())
+        ticking.reset_positions();
+      ticking.end_phase();
+      return ticking.pacman().points();
+    }));
+
+    //BatchEngine::step, one tick of BATCH_GAMES games with a key pressed every few ticks
+    vector<std::uint64_t> seeds(BATCH_GAMES);
+    for(int game = 0; game < BATCH_GAMES; game++) {
+      seeds[game] = game + 1;
+    }
+    BatchEngine batch {shared, seeds};
+
+    vector<int> inputs(BATCH_GAMES);
+
+    results.push_back(run("BatchEngine::step/" + std::to_string(BATCH_GAMES) + "-games", maze, [&](long i) {
+      for(int game = 0; game < BATCH_GAMES; game++) {
+        inputs[game] = keys[(i / 8 + game) % 5];
+      }
+      batch.step(inputs.data());
+      return batch.score(0);
+    }));
+
+    //AgentEnv::step, with the observation planes kept up to date, starting a new game when one ends
+    AgentEnv env {shared, 1};
+    const Action actions[] {Action::up, Action::left, Action::down, Action::right, Action::none};
+
+    results.push_back(run("AgentEnv::step", maze, [&](long i) {
+      if(env.done())
+        env.reset(i);
+      return env.step(actions[(i / 8) % 5]).reward;
+    }));
+
+    if(render)
+      bench_render(maze, shared, results);
+  }
+
+  //time GameWindow::print on one maze, through a terminal sized window following pacman
+  void bench_render(const string& maze, const SharedLevel& shared, vector<Result>& results)
+  {
+    const Level& level = *shared;
+
+    PacMan pacman {level};
+    Ghost blinky {level.ghost(level.ghosts(GhostKind::blinky).first)};
+    Borders borders {level};
+    Points points {level};
+
+    const vector<Coord> open = open_cells(level);
+
+    GameWindow window {VIEW_H, VIEW_W, Coord{0, 0}};
+    window.show_maze(level.width(), level.height());
+    window.follow(&pacman);
+    window.add(&borders, WindowLayer::background);
+    window.add(&points, WindowLayer::background);
+    window.add(&pacman, WindowLayer::midground);
+    window.add(&blinky, WindowLayer::midground);
+
+    //pacman walks the open cells in order, so the camera scrolls along with it,
+    //eating a point every so often so the chunks in view are drawn again
+    results.push_back(run("GameWindow::print", maze, [&](long i) {
+      pacman.jump(open[i % open.size()]);
+      blinky.jump(open[(i * 7919) % open.size()]);
+      if(i % 8 == 0)
+        points.check_score(&pacman);
+      window.print();
+      return 0;
+    }));
+
+    //the same, with the frame written out to the terminal
+    results.push_back(run("GameWindow::print+doupdate", maze, [&](long i) {
+      pacman.jump(open[i % open.size()]);
+      blinky.jump(open[(i * 7919) % open.size()]);
+      if(i % 8 == 0)
+        points.check_score(&pacman);
+      window.print();
+      doupdate();
+      return 0;
+    }));
+  }
+
+  //open a lines x cols ncurses terminal on /dev/null
+  SCREEN* open_null_terminal(int lines, int cols)
+  {
+    FILE* out = std::fopen("/dev/null", "w");
+    FILE* in = std::fopen("/dev/null", "r");
+    if(!out || !in)
+      return nullptr;
+
+    setenv("LINES", std::to_string(lines).c_str(), 1);
+    setenv("COLUMNS", std::to_string(cols).c_str(), 1);
+
+    const char* term = std::getenv("TERM");
+    return newterm(term && *term ? term : "xterm", out, in);
+  }
+
+  void print_json(const vector<Result>& results)
+  {
+    std::cout << "{\n  \"benchmarks\": [\n";
+    for(std::size_t i = 0; i < results.size(); i++) {
+      const Result& r = results[i];
+      std::cout << "    {\"name\": \"" << r.name << "\", \"maze\": \"" << r.maze
+                << "\", \"iterations\": " << r.iterations
+                << ", \"ns_per_op\": " << r.ns_per_op
+                << ", \"allocs_per_op\": " << r.allocs_per_op << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ]\n}\n";
+  }
+
+  /*
+   * Play VERIFY_GAMES games on one maze in a BatchEngine and the same games, with
+   * the same seeds and inputs, in GameCores, running the resets Game::game_loop
+   * runs, and compare their state hashes after every tick. The inputs are random
+   * keys, so the games go through deaths, game overs and, on small mazes, level
+   * changes. Returns false after reporting the first tick the hashes differ.
+   */
+  bool verify_maze(const string& maze, const SharedLevel& shared)
+  {
+    const int keys[] {Inputs::UP, Inputs::LEFT, Inputs::DOWN, Inputs::RIGHT, Inputs::NO_INPUT};
+
+    vector<std::uint64_t> seeds(VERIFY_GAMES);
+    vector<std::unique_ptr<GameCore>> cores;
+    vector<Rng> rngs;
+    for(int game = 0; game < VERIFY_GAMES; game++) {
+      seeds[game] = game + 1;
+      cores.push_back(std::make_unique<GameCore>(shared, seeds[game]));
+      rngs.emplace_back(seeds[game] * 7919);
+    }
+    BatchEngine batch {shared, seeds};
+
+    vector<int> inputs(VERIFY_GAMES);
+    long game_overs {0};
+    long levels_cleared {0};
+
+    for(long tick = 0; tick < VERIFY_TICKS; tick++) {
+      for(int game = 0; game < VERIFY_GAMES; game++) {
+        inputs[game] = keys[rngs[game].below(5)];
+      }
+      batch.step(inputs.data());
+
+      for(int game = 0; game < VERIFY_GAMES; game++) {
+        GameCore& core = *cores[game];
+        core.pacman_phase(inputs[game]);
+        core.ghost_phase();
+        core.score_phase();
+        if(core.game_over()) {
+          core.reset_game();
+          game_overs++;
+        }
+        if(core.level_cleared()) {
+          core.next_level();
+          levels_cleared++;
+        }
+        if(core.pacman_eaten())
+          core.reset_positions();
+        core.end_phase();
+
+        if(core.state_hash() != batch.state_hash(game)) {
+          std::cerr << "pacman-bench: " << maze << " seed " << seeds[game] << " tick " << tick
+                    << ": GameCore hash " << core.state_hash()
+                    << ", BatchEngine hash " << batch.state_hash(game) << "\n";
+          return false;
+        }
+      }
+    }
+
+    std::cout << maze << ": " << VERIFY_GAMES << " games x " << VERIFY_TICKS << " ticks match, "
+              << game_overs << " game overs, " << levels_cleared << " levels cleared\n";
+    return true;
+  }
+
+  //check BatchEngine against GameCore on every embedded level and a few synthetic mazes
+  int verify()
+  {
+    vector<std::pair<string, SharedLevel>> mazes;
+    for(int i = 0; i < embedded_level_count(); i++) {
+      mazes.emplace_back("level_" + std::to_string(i + 1), std::make_shared<const Level>(embedded_level(i)));
+    }
+    mazes.emplace_back("synthetic_6x8", std::make_shared<const Level>(synthetic_level(6, 8)));
+    mazes.emplace_back("synthetic_64x128", std::make_shared<const Level>(synthetic_level(64, 128)));
+    mazes.emplace_back("synthetic_64x128_64-ghosts", std::make_shared<const Level>(synthetic_level(64, 128, 64)));
+
+    for(const auto& [maze, shared] : mazes) {
+      if(!verify_maze(maze, shared))
+        return 1;
+    }
+    return 0;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  vector<Result> results;
+
+  try {
+    if(argc > 1 && string{argv[1]} == "--verify")
+      return verify();
+
+    SharedLevel level_1 = std::make_shared<const Level>(embedded_level());
+    SharedLevel medium = std::make_shared<const Level>(synthetic_level(64, 128));
+    SharedLevel large = std::make_shared<const Level>(synthetic_level(256, 512));
+    SharedLevel crowded = std::make_shared<const Level>(synthetic_level(64, 128, 64));
+    SharedLevel huge = std::make_shared<const Level>(synthetic_level(1024, 512));
+
+    SCREEN* screen = open_null_terminal(VIEW_H, VIEW_W);
+    if(!screen)
+      std::cerr << "pacman-bench: could not open a terminal on /dev/null, skipping rendering\n";
+
+    bench_maze("level_1", level_1, screen, results);
+    bench_maze("synthetic_" + std::to_string(medium->width()) + "x" + std::to_string(medium->height()), medium, screen, results);
+    bench_maze("synthetic_" + std::to_string(large->width()) + "x" + std::to_string(large->height()), large, screen, results);
+    bench_maze("synthetic_" + std::to_string(crowded->width()) + "x" + std::to_string(crowded->height()) + "_"
+               + std::to_string(crowded->ghost_count()) + "-ghosts", crowded, screen, results);
+
+    //only rendered, to show a frame costs the same on a maze of a million cells
+    if(screen)
+      bench_render("synthetic_" + std::to_string(huge->width()) + "x" + std::to_string(huge->height()), huge, results);
+
+    if(screen) {
+      endwin();
+      delscreen(screen);
+    }
+  } catch(const LevelError& e) {
+    std::cerr << "pacman-bench: " << e.what() << "\n";
+    return 1;
+  }
+
+  print_json(results);
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include "clock.h"
+
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+using std::chrono::milliseconds;
+using std::chrono::microseconds;
+
+TickClock::TickClock(milliseconds period, int max_catch_up)
+  :
+  m_period {period},
+  m_max_catch_up {max_catch_up},
+  m_deadline {Clock::now() + period}
+{}
+
+milliseconds TickClock::period() const { return m_period; }
+
+void TickClock::set_period(milliseconds period) { m_period = period; }
+
+void TickClock::restart()
+{
+  m_deadline = Clock::now() + m_period;
+}
+
+void TickClock::wait()
+{
+  Clock::time_point now = Clock::now();
+
+  if(now <= m_deadline) {                       //on time, sleep off the rest of the tick
+    std::this_thread::sleep_until(m_deadline);
+    m_deadline += m_period;
+    return;
+  }
+
+  //late, dont sleep so the next tick can catch up
+  Clock::duration late = now - m_deadline;
+  m_missed++;
+  m_max_late = std::max(m_max_late, late);
+
+  if(late > m_period * m_max_catch_up) {        //too far behind to catch up
+    m_dropped += late / m_period;               //drop the ticks we missed
+    m_deadline = now + m_period;                //and start again from now
+  } else {
+    m_deadline += m_period;
+  }
+}
+
+long TickClock::missed() const { return m_missed; }
+
+long TickClock::dropped() const { return m_dropped; }
+
+microseconds TickClock::max_late() const
+{
+  return std::chrono::duration_cast<microseconds>(m_max_late);
+}
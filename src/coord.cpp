@@ -1,5 +1,8 @@
 #include "coord.h"
 
+#include <algorithm>
+#include <cstdint>
+
 bool operator==(const Coord& l, const Coord& r)
 {
   return l.y == r.y && l.x == r.x;
@@ -27,3 +30,22 @@ int squared_dist(const Coord& l, const Coord& r)
   return x_diff * x_diff + y_diff * y_diff;
 }
 
+
+bool contains(const Rect& rect, Coord coord)
+{
+  return coord.x >= rect.origin.x && coord.x - rect.origin.x < rect.width
+         && coord.y >= rect.origin.y && coord.y - rect.origin.y < rect.height;
+}
+
+Rect intersect(const Rect& l, const Rect& r)
+{
+  //64 bit ends, so a rect as wide as an int can go still works
+  std::int64_t left = std::max(l.origin.x, r.origin.x);
+  std::int64_t top = std::max(l.origin.y, r.origin.y);
+  std::int64_t right = std::min<std::int64_t>(std::int64_t{l.origin.x} + l.width, std::int64_t{r.origin.x} + r.width);
+  std::int64_t bottom = std::min<std::int64_t>(std::int64_t{l.origin.y} + l.height, std::int64_t{r.origin.y} + r.height);
+
+  return Rect{Coord{static_cast<int>(left), static_cast<int>(top)},
+              static_cast<int>(std::max<std::int64_t>(right - left, 0)),
+              static_cast<int>(std::max<std::int64_t>(bottom - top, 0))};
+}
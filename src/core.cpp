@@ -0,0 +1,911 @@
+#include "core.h"
+#include "metrics.h"
+#include "config.h"
+#include "coord.h"
+#include "pieces.h"
+#include "ghosts.h"
+#include "level.h"
+
+#include <vector>
+#include <limits>
+#include <utility>
+
+using std::vector;
+
+GameCore::GameCore(SharedLevel level, std::uint64_t seed)
+  : GameCore(nullptr, std::move(level), seed)
+{}
+
+GameCore::GameCore(std::shared_ptr<LevelPack> pack, std::uint64_t seed)
+  : GameCore(pack, pack->level(GameConfig::STARTING_LEVEL), seed)
+{
+  m_pack->prefetch(GameConfig::STARTING_LEVEL + 1);
+}
+
+GameCore::GameCore(std::shared_ptr<LevelPack> pack, SharedLevel level, std::uint64_t seed)
+:
+  m_pack {std::move(pack)},
+  m_level {std::move(level)},
+  m_pacman {*m_level},
+  m_borders {*m_level},
+  m_grid {m_level->grid()},
+  m_nav {m_level->nav()},
+  m_junctions {&m_level->junctions()},
+  m_points {*m_level},
+  m_power_ups {*m_level},
+  m_left_warp {*m_level},
+  m_right_warp {*m_level},
+  m_rng {seed}
+{
+  load_ghosts();
+}
+
+/******************************** TICK PHASES ********************************/
+
+void GameCore::pacman_phase(int input)
+{
+  //move pacman
+  move_pacman(input);
+
+  //check for eaten pieces
+  check_pacman_eaten();
+  check_ghosts_eaten();
+}
+
+void GameCore::ghost_phase()
+{
+  if(!m_pacman.eaten()) {   //dont move ghost if pacman was eaten
+    move_ghosts();
+
+    //check for eaten pieces
+    check_pacman_eaten();
+    check_ghosts_eaten();
+  }
+}
+
+void GameCore::score_phase()
+{
+  //check scores
+  check_points_scored();
+  check_power_ups_scored();
+
+  //increment pacmans score
+  calc_pacman_score();
+
+  //update states
+  update_power_ups_state();
+  update_ghost_states();
+  update_pursuit_state();
+}
+
+void GameCore::end_phase()
+{
+  //reset score and eaten flags
+  reset_piece_flags();
+
+  //blink power ups
+  blink_power_ups();
+}
+
+bool GameCore::game_over() const { return m_pacman.lives() <= 0; }
+
+bool GameCore::level_cleared() { return m_points.all_eaten(); }
+
+bool GameCore::pacman_eaten() { return m_pacman.eaten(); }
+
+bool GameCore::point_scored() { return m_points.score(); }
+
+bool GameCore::power_up_scored() { return m_power_ups.score(); }
+
+/********************************** RESETS ***********************************/
+
+void GameCore::reset_positions()
+{
+  m_pacman.jump_home(Momentum::left);     //send pacman home
+
+  for(Ghost& ghost : m_ghosts) {          //reset ghosts
+    ghost.reset();
+  }
+}
+
+void GameCore::next_level()
+{
+  m_game_level++;                         //inc level number
+  load_maze(m_game_level);                //the new levels maze moves everyones home
+
+  m_pacman.jump_home(Momentum::left);     //send pacman and ghosts home
+  for(Ghost& ghost : m_ghosts) {
+    ghost.jump_home(Momentum::still);
+  }
+
+  m_points.reset();                       //reset points and power ups
+  m_power_ups.reset();
+
+  if(m_metrics)
+    m_metrics->level_resets.add();
+}
+
+void GameCore::reset_game()
+{
+  m_game_level = 1;   //go back to level 1
+  load_maze(m_game_level);
+
+  m_pacman.reset();   //reset pacman
+
+  for(Ghost& ghost : m_ghosts) {    //reset ghosts
+    ghost.reset();
+  }
+
+  m_points.reset();   //reset points and power ups
+  m_power_ups.reset();
+
+  m_power_up_timer = 0;      //reset timers
+  m_pursuit_state_timer = 0;
+  m_power_up_blink_timer = 0;
+
+  m_pursuit_state = PursuitState::scatter;  //go to scatter state
+
+  if(m_metrics)
+    m_metrics->level_resets.add();
+}
+
+void GameCore::load_maze(int game_level)
+{
+  if(!m_pack)
+    return;
+
+  SharedLevel level = m_pack->level(game_level);    //a pointer swap once the prefetch is done
+  m_pack->prefetch(game_level + 1);
+  if(level != m_level)
+    swap_maze(std::move(level));
+}
+
+bool GameCore::reload_maze(int maze, SharedLevel level)
+{
+  if(!m_pack || m_pack->maze(m_game_level) != maze)
+    return false;
+
+  swap_maze(std::move(level));     //puts every point and power up back
+  reset_positions();                //the old positions may be walls now
+  return true;
+}
+
+void GameCore::swap_maze(SharedLevel level)
+{
+  m_level = std::move(level);
+
+  m_pacman.load(*m_level);
+  load_ghosts();
+
+  m_borders.load(*m_level);
+  m_grid = m_level->grid();
+  m_nav = m_level->nav();
+  m_junctions = &m_level->junctions();
+
+  m_points.load(*m_level);
+  m_power_ups.load(*m_level);
+
+  m_left_warp.load(*m_level);
+  m_right_warp.load(*m_level);
+}
+
+void GameCore::load_ghosts()
+{
+  //the ghosts both mazes have keep their state, extra ones start at home
+  int count = m_level->ghost_count();
+  if(static_cast<int>(m_ghosts.size()) > count)
+    m_ghosts.erase(m_ghosts.begin() + count, m_ghosts.end());
+
+  for(int n = 0; n < count; n++) {
+    if(n < static_cast<int>(m_ghosts.size()))
+      m_ghosts[n].load(m_level->ghost(n));
+    else
+      m_ghosts.emplace_back(m_level->ghost(n));
+  }
+
+  for(int kind = 0; kind < GHOST_KINDS; kind++) {
+    m_kinds[kind] = m_level->ghosts(static_cast<GhostKind>(kind));
+  }
+
+  const GhostRange& blinkies = m_kinds[static_cast<int>(GhostKind::blinky)];
+  m_partner = blinkies.first < blinkies.last ? blinkies.first : -1;
+
+  //the maze may have another size, index every ghost again so slots match m_ghosts
+  m_ghost_cells.clear(m_level->width(), m_level->height());
+  for(Ghost& ghost : m_ghosts) {
+    ghost.track(&m_ghost_cells);
+  }
+}
+
+/********************************** GETTERS **********************************/
+
+int GameCore::level() const { return m_game_level; }
+
+int GameCore::maze_width() const { return m_level->width(); }
+
+int GameCore::maze_height() const { return m_level->height(); }
+
+std::uint64_t GameCore::seed() const { return m_rng.seed(); }
+
+const PacMan& GameCore::pacman() const { return m_pacman; }
+
+void GameCore::set_metrics(Metrics* metrics) { m_metrics = metrics; }
+
+int GameCore::ghost_count() const { return m_ghosts.size(); }
+
+const Ghost& GameCore::ghost(int n) const { return m_ghosts[n]; }
+
+std::uint32_t GameCore::state_hash() const
+{
+  StateHash hash;
+
+  auto add_piece = [&hash](const DynamicPiece& piece) {
+    hash.add(piece.location().x);
+    hash.add(piece.location().y);
+    hash.add(piece.momentum());
+  };
+
+  add_piece(m_pacman);
+  hash.add(m_pacman.lives());
+  hash.add(m_pacman.points());
+
+  for(const Ghost& ghost : m_ghosts) {
+    add_piece(ghost);
+    hash.add(static_cast<int>(ghost.state()));
+  }
+
+  hash.add(m_power_up_timer);
+  hash.add(m_pursuit_state_timer);
+  hash.add(m_power_up_blink_timer);
+  hash.add(static_cast<int>(m_pursuit_state));
+  hash.add(static_cast<int>(m_power_ups.state()));
+  hash.add(m_points.remaining());
+  hash.add(m_power_ups.remaining());
+  hash.add(m_game_level);
+
+  return hash.value();
+}
+
+vector<Piece*> GameCore::actors()
+{
+  vector<Piece*> actors {&m_pacman};
+  for(Ghost& ghost : m_ghosts) {
+    actors.push_back(&ghost);
+  }
+  return actors;
+}
+
+vector<Piece*> GameCore::maze()
+{
+  return {&m_borders, &m_points, &m_power_ups};
+}
+
+/******************************** MOVEMENT ***********************************/
+
+void GameCore::move_pacman(int input)
+{
+  Coord current = m_pacman.location();
+  Coord up = current + Coord{0,-1};
+  Coord down = current + Coord{0,1};
+  Coord right = current + Coord{2,0};
+  Coord left = current + Coord{-2,0};
+
+  switch(input) {   //go to input direction
+    case Inputs::UP:
+    {
+      if(!m_grid.is_wall(up))   //check if direction is a collision
+        m_pacman.up();                                //if not move
+      else
+        pacman_keep_moving();                         //else keep moving in momentum direction
+      break;
+    }
+    case Inputs::DOWN:
+    {
+      if(!m_grid.is_wall(down))
+        m_pacman.down();
+      else 
+        pacman_keep_moving();
+      break;
+    }
+    case Inputs::RIGHT:
+    {
+      if(!m_grid.is_wall(right)) 
+        m_pacman.right(2);
+      else 
+        pacman_keep_moving();
+      break;
+    }
+    case Inputs::LEFT:
+    {
+      if(!m_grid.is_wall(left)) 
+        m_pacman.left(2);
+      else
+        pacman_keep_moving();
+      break;
+    }
+    default:
+    {
+      pacman_keep_moving();     //if no input direction then keep moving with momentum
+    }
+  }
+
+  check_for_warp(&m_pacman);    //check for a warp
+}
+
+void GameCore::pacman_keep_moving()
+{
+  Coord current = m_pacman.location();
+  Coord up = current + Coord{0,-1};
+  Coord down = current + Coord{0,1};
+  Coord right = current + Coord{2,0};
+  Coord left = current + Coord{-2,0};
+
+  switch(m_pacman.momentum()) {   //go to current momentum
+    case Momentum::up:
+    {
+      if(!m_grid.is_wall(up))   //see if momentum direct is a collision
+        m_pacman.up();                                //if not then move
+      break;                                          //else dont move
+    }
+    case Momentum::down:
+    {
+      if(!m_grid.is_wall(down))
+        m_pacman.down();
+      break;
+    }
+    case Momentum::left:
+    {
+      if(!m_grid.is_wall(left))
+        m_pacman.left(2);
+      break;
+    }
+    case Momentum::right:
+    {
+      if(!m_grid.is_wall(right))
+        m_pacman.right(2);
+      break;
+    }
+    default:
+    {
+      break;
+    }
+  }
+}
+
+void GameCore::move_ghosts()
+{
+  //each kinds ghosts move in turn, through a loop built for the kinds policy
+  for_each_ghost_kind([this](auto kind) {
+    constexpr GhostKind KIND = decltype(kind)::value;
+    move_ghosts<GhostPolicy<KIND>>(m_kinds[static_cast<int>(KIND)]);
+  });
+}
+
+template<typename Policy>
+void GameCore::move_ghosts(GhostRange range)
+{
+  ChaseView view = chase_view();    //taken per kind, so inky sees where blinky moved to
+
+  for(int n = range.first; n < range.last; n++) {
+    Ghost* ghost = &m_ghosts[n];
+    move_ghost(ghost, ghost_target<Policy>(ghost, view));   //move each ghost toward their target
+  }
+}
+
+void GameCore::move_ghost(Ghost* ghost, Coord target)
+{
+  //in a corridor the ghost only has one move, the destination is only worked out at junctions
+  Destination destination = corridor_destination(ghost);
+  if(destination == Destination::decide)
+    destination = calc_ghost_destination(ghost, target);   //use target to calculate ghosts destination
+
+  switch(destination) {   //go to destination and move
+    case Destination::go_up: 
+    {
+      ghost->up();
+      break;
+    }
+    case Destination::go_down: 
+    {
+      ghost->down();
+      break;
+    }
+    case Destination::go_left:
+    {
+      ghost->left(2);
+      break;
+    }
+    case Destination::go_right:
+    {
+      ghost->right(2);
+      break;
+    }
+    default:
+    {
+      break;    //if no destination stay still
+    }
+  }
+
+  check_for_warp(ghost);
+}
+
+GameCore::Destination GameCore::calc_ghost_destination(Ghost* ghost, Coord target)
+{
+  /* 
+   * Ghosts will move in the valid direction that minimizes the distance to target
+   *
+   * The distance is the path distance from the levels nav fields, or the linear
+   * distance if no field covers the target
+   *
+   * Ghost can only turn around during the first turn after a power up has been activated
+   * or if a ghost is trapped in a corner with only the space behind it being valid
+   *
+   */
+
+  Coord current = ghost->location();
+  Coord right = current + Coord{2,0};
+  Coord down = current + Coord{0,1};
+  Coord left = current + Coord{-2,0};
+  Coord up = current + Coord{0,-1};
+
+  Destination destination = Destination{Destination::stay_still};
+  int min_distance = std::numeric_limits<int>::max();
+
+  //eaten ghosts path through the ghost home door, everyone else only leaves through it
+  NavRules rules = ghost->state() == GhostState::eaten ? NavRules::eaten : NavRules::normal;
+  const std::uint16_t* field = m_nav.field(target, rules);
+  auto distance = [&](Coord coord) { return field ? m_nav.distance(field, coord) : scaled_distance(coord, target); };
+
+  //go through each direction
+  //first check if direction is valid
+  //if it is valid then check if its the new minimum distance
+
+  //can only turn around when in turn_around state
+  if(ghost->momentum() != Momentum::left || ghost->state() == GhostState::turn_around) {
+    if(!m_grid.is_border(right)) {                             //cant go into borders
+      if(!m_grid.is_inv_wall(right)) {                          //cant go into an inv wall
+        if(distance(right) <= min_distance) {  //check if min distance
+          destination = Destination::go_right;            //if it is update direction
+          min_distance = distance(right);   //set new direction
+        }
+      }
+    }
+  }
+
+  if(ghost->momentum() != Momentum::up || ghost->state() == GhostState::turn_around) {
+    if(!m_grid.is_border(down)) {
+      if(!m_grid.is_inv_wall(down) || ghost->state() == GhostState::eaten) {  //we can go down through inv wall if eaten
+        if(distance(down) <= min_distance) {
+          destination = Destination::go_down;
+          min_distance = distance(down);
+        }
+      }
+    }
+  }
+
+  if(ghost->momentum() != Momentum::right || ghost->state() == GhostState::turn_around) {
+    if(!m_grid.is_border(left)) {
+      if(!m_grid.is_inv_wall(left)) {
+        if(distance(left) <= min_distance) {
+          destination = Destination::go_left;
+          min_distance = distance(left);
+        }
+      }
+    }
+  }
+
+  if(ghost->momentum() != Momentum::down || ghost->state() == GhostState::turn_around) {
+    if(!m_grid.is_border(up)) {
+      if(!m_grid.is_inv_wall(up) || true) {       //ghosts can always go up through inv walls
+        if(distance(up) <= min_distance) {
+          destination = Destination::go_up;
+          min_distance = distance(up);
+        }
+      }
+    }
+  }
+
+
+  //now we can check if ghost is boxed in in three directions exept one
+  if(destination == Destination::stay_still) {
+    if(m_grid.is_border(left) && m_grid.is_border(right) && m_grid.is_border(up)) {
+      if(!m_grid.is_border(down))                //if only one valid direction ghost can turn around
+        destination = Destination::go_down;
+    } else if(m_grid.is_border(left) && m_grid.is_border(right) && m_grid.is_border(down)) {
+      if(!m_grid.is_border(up))
+        destination = Destination::go_up;
+    } else if(m_grid.is_border(left) && m_grid.is_border(up) && m_grid.is_border(down)) {
+      if(!m_grid.is_border(right))
+        destination = Destination::go_right;
+    } else if(m_grid.is_border(right) && m_grid.is_border(up) && m_grid.is_border(down)) {
+      if(!m_grid.is_border(left))
+        destination = Destination::go_left;
+    }
+  }
+
+  return destination;
+}
+
+GameCore::Destination GameCore::corridor_destination(Ghost* ghost)
+{
+  //turning around can go back the way it came, so its always a decision
+  if(ghost->state() == GhostState::turn_around)
+    return Destination::decide;
+
+  NavMove heading {NavMove::none};
+  switch(ghost->momentum()) {
+    case Momentum::right: heading = NavMove::right; break;
+    case Momentum::down:  heading = NavMove::down;  break;
+    case Momentum::left:  heading = NavMove::left;  break;
+    case Momentum::up:    heading = NavMove::up;    break;
+    case Momentum::still: break;
+  }
+
+  switch(m_junctions->corridor_move(ghost->location(), heading)) {
+    case NavMove::right: return Destination::go_right;
+    case NavMove::down:  return Destination::go_down;
+    case NavMove::left:  return Destination::go_left;
+    case NavMove::up:    return Destination::go_up;
+    default:             return Destination::decide;
+  }
+}
+
+void GameCore::check_for_warp(DynamicPiece* p)
+{
+  if(p->in(&m_left_warp)) {                 //if in left warp, jump to right warp
+    p->jump(m_right_warp.location());
+  } else if(p->in(&m_right_warp)) {          // if in right warp, jump to left warp
+    p->jump(m_left_warp.location());
+  }
+}
+
+Coord GameCore::random_target(Ghost* ghost) 
+{
+  enum class Direction{up,down,left,right};
+
+  switch(static_cast<Direction>( m_rng.below(4)) ) { //choose random direction
+    case Direction::up:
+    {
+      return ghost->location() + Coord{0,-1};
+    }
+    case Direction::down:
+    {
+      return ghost->location() + Coord{0,1};
+    }
+    case Direction::right:
+    {
+      return ghost->location() + Coord{2,0};
+    }
+    case Direction::left:
+    {
+      return ghost->location() + Coord{-2,0};
+    }
+  };
+
+  return ghost->location();
+}
+
+Coord GameCore::behind_target(Ghost* ghost)
+{
+  switch(ghost->momentum()) {   //look at momentum and go in oposite direction
+    case Momentum::up:
+    {
+      return ghost->location() + Coord{0,1};
+    }
+    case Momentum::down:
+    {
+      return ghost->location() + Coord{0,-1};
+    }
+    case Momentum::left:
+    {
+      return ghost->location() + Coord{2,0};
+    }
+    case Momentum::right:
+    {
+      return ghost->location() + Coord{-2,0};
+    }
+    case Momentum::still:
+    {
+      return ghost->location();
+    }
+  }
+  return ghost->location();
+}
+
+template<typename Policy>
+Coord GameCore::ghost_target(Ghost* ghost, const ChaseView& view)
+{
+  Coord target = ghost->location();
+
+  switch(ghost->state()) {    //look at state and determin target
+    case GhostState::chase:
+    {
+      target = Policy::target(ghost->location(), ghost->scatter_target(), view);
+      break;
+    }
+    case GhostState::scatter:
+    {
+      target = ghost->scatter_target();
+      break;
+    }
+    case GhostState::eaten:
+    {
+      target = ghost->home();
+      break;
+    }
+    case GhostState::frightened:
+    {
+      target = random_target(ghost);    //if frightened go in random direction
+      break;
+    }
+    case GhostState::turn_around:
+    {
+      target = behind_target(ghost);   //get coord behind ghost if turning around
+      break;
+    }
+  };
+  return target;
+}
+
+ChaseView GameCore::chase_view()
+{
+  Coord partner = m_partner >= 0 ? m_ghosts[m_partner].location() : Coord{0,0};
+  return ChaseView{m_pacman.location(), two_infront_of_pacman(), partner, m_nav};
+}
+
+Coord GameCore::two_infront_of_pacman()
+{
+  switch(m_pacman.momentum()) {
+    case Momentum::up:
+    {
+      return m_pacman.location() + Coord{0,-2};
+    }
+    case Momentum::down:
+    {
+      return m_pacman.location() + Coord{0,2};
+    }
+    case Momentum::left:
+    {
+      //ghosts and pacman move 2 spaces left or right, so go 4 coords over
+      return m_pacman.location() + Coord{-4,0};
+    }
+    case Momentum::right:
+    {
+      return m_pacman.location() + Coord{4,0};
+    }
+    default:
+    {
+      return m_pacman.location();
+    }
+  }
+}
+
+void GameCore::update_pursuit_state()
+{
+  /*
+   * game alternates between chase and scatter mode for the whole game
+   */
+
+  switch(m_pursuit_state) {         // go to current state and calc next state
+    case PursuitState::chase:
+      if(m_pursuit_state_timer == GameConfig::CHASE_LENGTH) {   //if timer is up
+        m_pursuit_state = PursuitState::scatter;  //go to scatter state
+        m_pursuit_state_timer = 0;                //and reset timer
+      } else {
+        m_pursuit_state = PursuitState::chase;  //else stay in chase and keep countin up
+        m_pursuit_state_timer++;
+      }
+      break;
+    case PursuitState::scatter:
+      if(m_pursuit_state_timer == GameConfig::SCATTER_LENGTH) {   //if timer is up
+        m_pursuit_state = PursuitState::chase;      //go to chase
+        m_pursuit_state_timer = 0;                  //reset timer
+      } else {
+        m_pursuit_state = PursuitState::scatter;  //else stay in scatter and keep countin up
+        m_pursuit_state_timer++;
+      }
+      break;
+  }
+}
+
+void GameCore::update_ghost_state(Ghost* ghost)
+{
+  /*
+   * Ghost has the following states
+   *
+   * Chase:: pursue pacman until power up activated, or game switches pursuit_states
+   * Scatter:: go to scatter chord until power up activated, of game switches pursuit states
+   *
+   * turn around:: if power up activated, turn around for one turn then go to frightened, unless eaten
+   *
+   * frightened:: go in random direction, until eaten or power up is turned off
+   *
+   * eaten:: go back to home coord, then go back to appropriate pursuit state
+   *
+   */
+
+  switch(ghost->state()) {
+    case GhostState::chase:
+    case GhostState::scatter:
+    {
+      if(m_power_ups.score()) {
+        ghost->set_state(GhostState::turn_around);  //if power up scores, turn around
+      } else {
+        ghost->set_state(m_pursuit_state);  //else look at pursuit_state and go to chase or scatter
+      }
+      break;
+    }
+    case GhostState::turn_around:
+    {
+      if(ghost->eaten()) {
+        ghost->set_state(GhostState::eaten);      //if eaten, go to eaten state
+      } else {
+        ghost->set_state(GhostState::frightened); //else go to frightened state
+      }
+      break;
+    }
+    case GhostState::frightened:
+    {
+      if(ghost->eaten()) {
+        ghost->set_state(GhostState::eaten);            //if eaten go to eaten
+      } else if(m_power_ups.state() == PowerUpState::off) {
+        ghost->set_state(m_pursuit_state);              //if power up turns off go to chase or scatter
+      } else {
+        ghost->set_state(GhostState::frightened);      //else stay frightened
+      }
+      break;
+    }
+    case GhostState::eaten:
+    {
+      if(ghost->is_home()) {
+        ghost->set_state(m_pursuit_state);    //if we are home go back to chase/scatter
+      } else {
+        ghost->set_state(GhostState::eaten);    //else stay eaten
+      }
+      break;
+    }
+  };
+}
+
+void GameCore::update_ghost_states()
+{
+  for(Ghost& ghost : m_ghosts) {
+    update_ghost_state(&ghost);
+  }
+}
+
+void GameCore::update_power_ups_state()
+{
+  switch(m_power_ups.state()) {   //go to state, and calc next state
+    case PowerUpState::off:
+    {
+      if(m_power_ups.score()) {
+        m_power_up_timer = GameConfig::POWER_UP_LENGTH; //if we scored a powerup, start power up timer
+        m_power_ups.set_state(PowerUpState::active);   //go to active state
+      } else {
+        m_power_ups.set_state(PowerUpState::off);     //else stay turned off
+      }
+      break;
+    }
+    case PowerUpState::active:
+    {
+      if(m_power_ups.score()) {
+        m_power_up_timer = GameConfig::POWER_UP_LENGTH; //if we scored another powerup, reset timer
+        m_power_ups.set_state(PowerUpState::active);  //stay activated
+      } else if(m_power_up_timer <= 0) {
+        m_power_ups.set_state(PowerUpState::off);   //if timer is up, turn off power up
+      } else {
+        m_power_up_timer--;                           //else stay active, and dec timer
+        m_power_ups.set_state(PowerUpState::active);
+      }
+      break;
+    }
+  }
+
+}
+
+void GameCore::calc_pacman_score()
+{
+  if(m_points.score())                        //if points score, inc points
+    m_pacman.inc_points(m_points.value());
+
+  if(m_power_ups.score())                     //if power up score, inc points
+    m_pacman.inc_points(m_power_ups.value());
+
+  int ghosts_eaten {0};
+  for(Ghost& ghost : m_ghosts) {              //chech for eaten ghosts and inc points
+    if(ghost.eaten()) {
+      m_pacman.inc_points(ghost.value());
+      ghosts_eaten++;
+    }
+  }
+
+  if(m_metrics) {                             //count what was eaten
+    m_metrics->pellets_eaten.add(m_points.score());
+    m_metrics->power_ups_eaten.add(m_power_ups.score());
+    m_metrics->ghosts_eaten.add(ghosts_eaten);
+  }
+}
+
+template<typename F, typename K>
+Ghost* GameCore::ghost_on_pacman(F accept, K order)
+{
+  //only ghosts on one of pacmans cells can touch it
+  int first {-1};
+  for(Coord cell : m_pacman.shape()) {
+    m_ghost_cells.for_each_at(cell + m_pacman.location(), [&](int slot) {
+      if((first < 0 || order(slot) < order(first)) && accept(m_ghosts[slot]))
+        first = slot;
+    });
+  }
+  return first < 0 ? nullptr : &m_ghosts[first];
+}
+
+bool GameCore::check_pacman_eaten()
+{
+  if(!m_pacman.eaten()) { //pacman can only be eaten once
+    //can only be eaten by one ghost at a time, the first one that eats pacman
+    Ghost* ghost = ghost_on_pacman([this](Ghost& ghost) { return ghost.eats(&m_pacman); },
+                                   [](int slot) { return slot; });      //in roster order
+    if(ghost && m_pacman.check_eaten(ghost)) {
+      if(m_metrics)
+        m_metrics->deaths.add();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool GameCore::check_points_scored()
+{
+  //can only score points if pacman wasnt eaten
+  if(!m_pacman.eaten())
+    return m_points.check_score(&m_pacman);
+  return false;
+}
+
+bool GameCore::check_power_ups_scored()
+{
+  //can only score a power up if pacman wasnt eaten
+  if(!m_pacman.eaten())
+    return m_power_ups.check_score(&m_pacman);
+  return false;
+}
+
+bool GameCore::check_ghosts_eaten()
+{
+  bool ghost_eaten {false};
+
+  if(!m_pacman.eaten()) {     //cant eat a ghost if pacman is eaten
+    //pacman eats one ghost at a time, the first one it can in GHOST_EAT_ORDER, a ghost cant be eaten twice
+    int ghosts = m_ghosts.size();
+    auto order = [this, ghosts](int slot) { return ghost_eat_rank(m_ghosts[slot].kind()) * ghosts + slot; };
+    Ghost* ghost = ghost_on_pacman([](Ghost& ghost) { return !ghost.eaten() && ghost.edible(); }, order);
+    if(ghost)
+      ghost_eaten = ghost->check_eaten(&m_pacman);
+  }
+  return ghost_eaten;
+}
+
+void GameCore::reset_piece_flags()
+{
+  m_pacman.reset_eaten_flag();
+
+  for(Ghost& ghost : m_ghosts) {
+    ghost.reset_eaten_flag();
+  }
+
+  m_points.reset_score_flag();
+  m_power_ups.reset_score_flag();
+}
+
+void GameCore::blink_power_ups()
+{
+  //blink power ups every POWER_UP_BLINK_LENGTH turns
+  if(m_power_up_blink_timer <= 0) {
+    m_power_ups.blink();
+    m_power_up_blink_timer = ::GameConfig::POWER_UP_BLINK_LENGTH;
+  } else {
+    m_power_up_blink_timer--;
+  }
+}
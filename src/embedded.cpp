@@ -0,0 +1,70 @@
+#include "level.h"
+#include "level_text.h"
+
+#include <string_view>
+#include <iterator>
+#include <cstdint>
+
+/*
+ * The levels built into the binary. make turns each levels text files into an
+ * include of raw string literals, which are checked and parsed here at compile
+ * time, so a malformed level fails the build instead of the game.
+ */
+
+namespace
+{
+  namespace Level1
+  {
+#include "level_1.inc"      //LOCATIONS and SHAPES, generated by make from assets/level_1_*.txt
+  }
+
+  namespace Level2
+  {
+#include "level_2.inc"
+  }
+
+  //one levels text, checked and parsed at compile time
+  template<const std::string_view& Locations, const std::string_view& Shapes>
+  struct Embedded
+  {
+    static constexpr LevelTextSize size {level_text_size(Shapes)};
+    static constexpr LevelTextGhosts ghosts {count_ghosts(Locations)};
+
+    static_assert(parse_locations(Locations).missing < 0, "embedded level is missing a location symbol");
+    static_assert(ghosts.missing_scatter < 0, "embedded level has a ghost with no scatter symbol");
+    static_assert(ghosts.count > 0, "embedded level has no ghosts");
+    static_assert(size.width > 0 && size.height > 0, "embedded level has no cells");
+    static_assert(has_border(Shapes), "embedded level has no border '#'");
+
+    static constexpr EmbeddedLevel<size.width, size.height, ghosts.count> level {
+      parse_embedded_level<size.width, size.height, ghosts.count>(Locations, Shapes)};
+
+    static constexpr std::uint64_t checksum {text_checksum(Shapes, text_checksum(Locations))};
+
+    static Level build()
+    {
+      return Level::from_image(build_level_image(level.locations, level.width, level.height, level.tiles,
+                                                 level.ghosts, level.ghost_count));
+    }
+  };
+
+  struct EmbeddedEntry
+  {
+    Level (*build)();
+    std::uint64_t checksum;
+  };
+
+  using EmbeddedLevel1 = Embedded<Level1::LOCATIONS, Level1::SHAPES>;
+  using EmbeddedLevel2 = Embedded<Level2::LOCATIONS, Level2::SHAPES>;
+
+  constexpr EmbeddedEntry EMBEDDED_LEVELS[] {
+    {EmbeddedLevel1::build, EmbeddedLevel1::checksum},
+    {EmbeddedLevel2::build, EmbeddedLevel2::checksum},
+  };
+}
+
+int embedded_level_count() { return std::size(EMBEDDED_LEVELS); }
+
+Level embedded_level(int index) { return EMBEDDED_LEVELS[index].build(); }
+
+std::uint64_t embedded_level_checksum(int index) { return EMBEDDED_LEVELS[index].checksum; }
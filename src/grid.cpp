@@ -0,0 +1,173 @@
+#include "grid.h"
+#include "coord.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+using std::uint8_t;
+using std::uint64_t;
+
+TileGrid::TileGrid(int width, int height, const uint8_t* tiles)
+  :
+  m_width {width},
+  m_height {height},
+  m_tiles {tiles}
+{}
+
+int TileGrid::width() const { return m_width; }
+
+int TileGrid::height() const { return m_height; }
+
+bool TileGrid::in_bounds(Coord coord) const
+{
+  return coord.x >= 0 && coord.x < m_width && coord.y >= 0 && coord.y < m_height;
+}
+
+uint8_t TileGrid::at(Coord coord) const
+{
+  if(!in_bounds(coord))
+    return Tile::EMPTY;
+  return m_tiles[coord.y * m_width + coord.x];
+}
+
+bool TileGrid::is_border(Coord coord) const { return at(coord) & Tile::BORDER; }
+
+bool TileGrid::is_inv_wall(Coord coord) const { return at(coord) & Tile::INV_WALL; }
+
+bool TileGrid::is_wall(Coord coord) const { return at(coord) & (Tile::BORDER | Tile::INV_WALL); }
+
+/******************************** TILEBITSET *********************************/
+
+TileBitset::TileBitset(int width, int height)
+  :
+  m_width {width},
+  m_height {height},
+  m_words (bitset_words(width, height), 0)
+{}
+
+TileBitset::TileBitset(TileBitsetView view)
+  : TileBitset(view.width, view.height)
+{
+  copy_from(view);
+}
+
+int TileBitset::width() const { return m_width; }
+
+int TileBitset::height() const { return m_height; }
+
+bool TileBitset::in_bounds(Coord coord) const
+{
+  return coord.x >= 0 && coord.x < m_width && coord.y >= 0 && coord.y < m_height;
+}
+
+bool TileBitset::test(Coord coord) const
+{
+  if(!in_bounds(coord))
+    return false;
+  int index = coord.y * m_width + coord.x;
+  return (m_words[index / 64] >> (index % 64)) & 1;
+}
+
+void TileBitset::set(Coord coord)
+{
+  if(!in_bounds(coord))
+    return;
+  int index = coord.y * m_width + coord.x;
+  m_words[index / 64] |= uint64_t{1} << (index % 64);
+}
+
+void TileBitset::clear(Coord coord)
+{
+  if(!in_bounds(coord))
+    return;
+  int index = coord.y * m_width + coord.x;
+  m_words[index / 64] &= ~(uint64_t{1} << (index % 64));
+}
+
+int TileBitset::count() const
+{
+  int n {0};
+  for(uint64_t word : m_words) {
+    n += __builtin_popcountll(word);
+  }
+  return n;
+}
+
+void TileBitset::copy_from(TileBitsetView view)
+{
+  std::memcpy(m_words.data(), view.words, m_words.size() * sizeof(uint64_t));
+}
+
+TileBitsetView TileBitset::view() const
+{
+  return TileBitsetView{m_width, m_height, m_words.data()};
+}
+
+/******************************** PIECEINDEX *********************************/
+
+PieceIndex::PieceIndex(int width, int height)
+{
+  clear(width, height);
+}
+
+void PieceIndex::clear(int width, int height)
+{
+  m_width = width;
+  m_height = height;
+  m_heads.assign(width * height + 1, -1);
+  m_next.clear();
+  m_prev.clear();
+  m_locations.clear();
+}
+
+int PieceIndex::add(Coord location)
+{
+  int slot = m_locations.size();
+  m_locations.push_back(location);
+  m_next.push_back(-1);
+  m_prev.push_back(-1);
+  link(slot);
+  return slot;
+}
+
+void PieceIndex::moved(int slot, Coord location)
+{
+  if(list(location) == list(m_locations[slot])) {
+    m_locations[slot] = location;     //the same cell, or still off the grid
+    return;
+  }
+  unlink(slot);
+  m_locations[slot] = location;
+  link(slot);
+}
+
+int PieceIndex::size() const { return m_locations.size(); }
+
+int PieceIndex::list(Coord coord) const
+{
+  if(coord.x < 0 || coord.x >= m_width || coord.y < 0 || coord.y >= m_height)
+    return m_width * m_height;
+  return coord.y * m_width + coord.x;
+}
+
+void PieceIndex::link(int slot)
+{
+  int& head = m_heads[list(m_locations[slot])];
+  m_prev[slot] = -1;
+  m_next[slot] = head;
+  if(head >= 0)
+    m_prev[head] = slot;
+  head = slot;
+}
+
+void PieceIndex::unlink(int slot)
+{
+  if(m_prev[slot] >= 0)
+    m_next[m_prev[slot]] = m_next[slot];
+  else
+    m_heads[list(m_locations[slot])] = m_next[slot];
+
+  if(m_next[slot] >= 0)
+    m_prev[m_next[slot]] = m_prev[slot];
+}
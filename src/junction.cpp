@@ -0,0 +1,148 @@
+#include "junction.h"
+#include "coord.h"
+#include "grid.h"
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+using std::vector;
+
+namespace
+{
+  constexpr int MOVE_COUNT {4};
+
+  //ghosts move 2 cells left and right, 1 up and down
+  constexpr Coord MOVE_DELTAS[MOVE_COUNT] {{2,0}, {0,1}, {-2,0}, {0,-1}};
+
+  Coord step(Coord coord, NavMove move) { return coord + MOVE_DELTAS[static_cast<int>(move)]; }
+
+  NavMove reverse(NavMove move) { return static_cast<NavMove>((static_cast<int>(move) + 2) % MOVE_COUNT); }
+
+  //the moves out of coord as a bit per move, with the wall checks calc_ghost_destination uses
+  unsigned valid_moves(TileGrid grid, Coord coord, bool eaten)
+  {
+    unsigned moves {0};
+    for(int i = 0; i < MOVE_COUNT; i++) {
+      NavMove move = static_cast<NavMove>(i);
+      Coord next = step(coord, move);
+      if(grid.is_border(next))
+        continue;
+      if(grid.is_inv_wall(next) && move != NavMove::up && !(move == NavMove::down && eaten))
+        continue;
+      moves |= 1u << i;
+    }
+    return moves;
+  }
+
+  int count(unsigned moves) { return __builtin_popcount(moves); }
+}
+
+JunctionGraph::JunctionGraph(TileGrid grid, Coord left_warp, Coord right_warp, const vector<Coord>& starts)
+  :
+  m_width {grid.width()},
+  m_height {grid.height()},
+  m_junction_ids(static_cast<std::size_t>(m_width) * m_height, -1),
+  m_corridor_moves(static_cast<std::size_t>(m_width) * m_height * MOVE_COUNT, NavMove::none)
+{
+  auto index = [&](Coord coord) { return coord.y * m_width + coord.x; };
+
+  auto take_warp = [&](Coord coord) {
+    if(coord == left_warp)
+      return right_warp;
+    if(coord == right_warp)
+      return left_warp;
+    return coord;
+  };
+
+  //find every cell a ghost can reach, eaten ghosts reach the most
+  vector<bool> reached(m_junction_ids.size(), false);
+  vector<Coord> cells;
+
+  for(Coord start : starts) {
+    if(grid.in_bounds(start) && !reached[index(start)]) {
+      reached[index(start)] = true;
+      cells.push_back(start);
+    }
+  }
+
+  for(std::size_t head = 0; head < cells.size(); head++) {
+    unsigned moves = valid_moves(grid, cells[head], true);
+    for(int i = 0; i < MOVE_COUNT; i++) {
+      Coord next = take_warp(step(cells[head], static_cast<NavMove>(i)));
+      if((moves >> i & 1) && grid.in_bounds(next) && !reached[index(next)]) {
+        reached[index(next)] = true;
+        cells.push_back(next);
+      }
+    }
+  }
+
+  //junctions are the cells that dont have the same two moves out for every ghost
+  for(Coord cell : cells) {
+    unsigned moves = valid_moves(grid, cell, false);
+    if(count(moves) != 2 || moves != valid_moves(grid, cell, true)) {
+      m_junction_ids[index(cell)] = m_junctions.size();
+      m_junctions.push_back(cell);
+    }
+  }
+  m_corridor_cells = cells.size() - m_junctions.size();
+
+  //follow each move out of each junction to the next junction
+  m_edges.reserve(m_junctions.size() * MOVE_COUNT);
+  for(int from = 0; from < static_cast<int>(m_junctions.size()); from++) {
+    unsigned moves = valid_moves(grid, m_junctions[from], true);
+
+    for(int i = 0; i < MOVE_COUNT; i++) {
+      if(!(moves >> i & 1))
+        continue;
+
+      JunctionEdge edge {from, -1, static_cast<NavMove>(i), 0, {}};
+      NavMove heading = edge.first;
+      Coord cell = take_warp(step(m_junctions[from], heading));
+
+      while(grid.in_bounds(cell) && edge.length <= static_cast<int>(cells.size())) {
+        edge.cells.push_back(cell);
+        edge.length++;
+
+        if(m_junction_ids[index(cell)] >= 0) {
+          edge.to = m_junction_ids[index(cell)];
+          break;
+        }
+
+        //a corridor cell entered from one of its two moves leaves by the other
+        unsigned out = valid_moves(grid, cell, false);
+        unsigned back = 1u << static_cast<int>(reverse(heading));
+        if(!(out & back))
+          break;      //came in through a warp from a side the cell has no move to
+
+        NavMove forced = static_cast<NavMove>(__builtin_ctz(out & ~back));
+        m_corridor_moves[index(cell) * MOVE_COUNT + static_cast<int>(heading)] = forced;
+
+        heading = forced;
+        cell = take_warp(step(cell, heading));
+      }
+
+      m_edges.push_back(std::move(edge));
+    }
+  }
+}
+
+const vector<Coord>& JunctionGraph::junctions() const { return m_junctions; }
+
+const vector<JunctionEdge>& JunctionGraph::edges() const { return m_edges; }
+
+int JunctionGraph::corridor_cells() const { return m_corridor_cells; }
+
+bool JunctionGraph::is_junction(Coord coord) const
+{
+  if(coord.x < 0 || coord.x >= m_width || coord.y < 0 || coord.y >= m_height)
+    return false;
+  return m_junction_ids[coord.y * m_width + coord.x] >= 0;
+}
+
+NavMove JunctionGraph::corridor_move(Coord coord, NavMove heading) const
+{
+  if(heading == NavMove::none || coord.x < 0 || coord.x >= m_width || coord.y < 0 || coord.y >= m_height)
+    return NavMove::none;
+  return m_corridor_moves[(coord.y * m_width + coord.x) * MOVE_COUNT + static_cast<int>(heading)];
+}
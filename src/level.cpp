@@ -0,0 +1,524 @@
+#include "level.h"
+#include "level_text.h"
+#include "coord.h"
+#include "grid.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::ifstream;
+using std::string;
+using std::vector;
+using std::uint8_t;
+using std::uint16_t;
+using std::uint64_t;
+
+namespace
+{
+  //round n up to the next multiple of 8, so every section is aligned for 64 bit reads
+  uint64_t align(uint64_t n) { return (n + 7) & ~uint64_t{7}; }
+
+  //size of a bitset section, in bytes
+  uint64_t bitset_bytes(int width, int height)
+  {
+    return static_cast<uint64_t>(bitset_words(width, height)) * sizeof(uint64_t);
+  }
+
+  //size of the nav cell ids, in bytes
+  uint64_t nav_cells_bytes(int width, int height)
+  {
+    return static_cast<uint64_t>(width) * height * sizeof(uint16_t);
+  }
+
+  //size of the distance table, in bytes. Its left out of levels with too many cells
+  uint64_t nav_table_bytes(uint64_t cell_count)
+  {
+    if(cell_count > NAV_MAX_TABLE_CELLS)
+      return 0;
+    return cell_count * cell_count * sizeof(uint16_t);
+  }
+
+  constexpr std::size_t FILE_BLOCK {1 << 16};   //bytes read from a level file at a time
+
+  //call f(block) for each block of a file in order, throws LevelError if it cant be opened
+  template<typename F>
+  void read_blocks(const string& file, F f)
+  {
+    ifstream ist {file, std::ios::binary};
+    if(!ist)
+      throw LevelError{"could not open level file '" + file + "'"};
+
+    vector<char> block(FILE_BLOCK);
+    while(ist.read(block.data(), block.size()) || ist.gcount() > 0) {
+      f(std::string_view{block.data(), static_cast<std::size_t>(ist.gcount())});
+    }
+    if(ist.bad())
+      throw LevelError{"could not read level file '" + file + "'"};
+  }
+
+  //a level text that is read from its file a block at a time, every time it is scanned
+  struct LevelFileText
+  {
+    string file;
+  };
+
+  template<typename F>
+  void scan_level_text(const LevelFileText& text, F f)
+  {
+    Coord coord {0,0};
+    read_blocks(text.file, [&](std::string_view block) {
+      coord = scan_level_text(block, f, coord);   //a row can go on into the next block
+    });
+  }
+
+  //the marks of a locations file, read in one pass
+  LevelMarks read_level_marks(const string& file)
+  {
+    LevelMarks marks;
+    scan_level_text(LevelFileText{file}, [&](char c, Coord coord) {
+      if(is_level_mark(c))
+        marks.push_back(LevelMark{c, coord});
+    });
+    return marks;
+  }
+
+  //compile_level over any level texts, see level_text.h
+  template<typename LocationsText, typename ShapesText>
+  vector<uint8_t> compile_text(const LocationsText& locations_text, const ShapesText& shapes_text)
+  {
+    LevelTextLocations parsed = parse_locations(locations_text);
+    if(parsed.missing >= 0) {
+      const LocationSymbol& missing = LOCATION_SYMBOLS[parsed.missing];
+      throw LevelError{string{"level is missing the "} + missing.name + " '" + missing.symbol + "'"};
+    }
+
+    LevelTextGhosts ghosts = count_ghosts(locations_text);
+    if(ghosts.missing_scatter >= 0) {
+      const GhostSymbol& missing = GHOST_SYMBOLS[ghosts.missing_scatter];
+      throw LevelError{string{"level has a "} + missing.name + " start '" + missing.start
+                       + "' but no " + missing.name + " scatter '" + missing.scatter + "'"};
+    }
+    if(ghosts.count == 0)
+      throw LevelError{"level has no ghosts"};
+
+    LevelTextSize size = level_text_size(shapes_text);
+    if(size.width == 0 || size.height == 0)
+      throw LevelError{"level has no cells"};
+
+    vector<uint8_t> tiles(static_cast<std::size_t>(size.width) * size.height, Tile::EMPTY);
+    parse_tiles(shapes_text, size.width, tiles.data());
+
+    //looked for in the tiles, so a shapes file is only read twice
+    if(std::none_of(tiles.begin(), tiles.end(), [](uint8_t tile) { return tile & Tile::BORDER; }))
+      throw LevelError{"level has no border '#'"};
+
+    vector<LevelGhost> roster(ghosts.count);
+    parse_ghosts(locations_text, roster.data());
+
+    return build_level_image(parsed.locations, size.width, size.height, tiles.data(), roster.data(), ghosts.count);
+  }
+}
+
+/*********************************** LEVEL ***********************************/
+
+Level::~Level()
+{
+  release();
+}
+
+Level::Level(Level&& other) noexcept
+  :
+  m_image {std::move(other.m_image)},
+  m_mapping {std::exchange(other.m_mapping, nullptr)},
+  m_data {std::exchange(other.m_data, nullptr)},
+  m_size {std::exchange(other.m_size, 0)},
+  m_junctions {std::move(other.m_junctions)}
+{}
+
+Level& Level::operator=(Level&& other) noexcept
+{
+  if(this != &other) {
+    release();
+    m_image = std::move(other.m_image);
+    m_mapping = std::exchange(other.m_mapping, nullptr);
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_junctions = std::move(other.m_junctions);
+  }
+  return *this;
+}
+
+Level Level::from_image(vector<uint8_t> image)
+{
+  Level level;
+  level.m_image = std::move(image);
+  level.m_data = level.m_image.data();
+  level.m_size = level.m_image.size();
+  level.validate();
+  level.build_junctions();
+  return level;
+}
+
+Level Level::map_file(const string& file)
+{
+  int fd = open(file.c_str(), O_RDONLY);
+  if(fd < 0)
+    throw LevelError{"could not open level file '" + file + "'"};
+
+  struct stat st;
+  if(fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    throw LevelError{"could not read level file '" + file + "'"};
+  }
+
+  void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);    //the mapping stays valid after the fd is closed
+  if(mapping == MAP_FAILED)
+    throw LevelError{"could not map level file '" + file + "'"};
+
+  Level level;
+  level.m_mapping = mapping;
+  level.m_data = static_cast<const uint8_t*>(mapping);
+  level.m_size = st.st_size;
+
+  try {
+    level.validate();
+  } catch(const LevelError& e) {
+    throw LevelError{"'" + file + "': " + e.what()};
+  }
+  level.build_junctions();
+  return level;
+}
+
+const LevelLocations& Level::locations() const { return header().locations; }
+
+int Level::width() const { return header().width; }
+
+int Level::height() const { return header().height; }
+
+int Level::ghost_count() const { return header().ghost_count; }
+
+const LevelGhost& Level::ghost(int n) const
+{
+  return static_cast<const LevelGhost*>(section(LevelSection::ghosts))[n];
+}
+
+GhostRange Level::ghosts(GhostKind kind) const
+{
+  //the ghosts are sorted by kind, so find where the kind starts and ends
+  const LevelGhost* ghosts = static_cast<const LevelGhost*>(section(LevelSection::ghosts));
+  const LevelGhost* end = ghosts + ghost_count();
+
+  const LevelGhost* first = std::find_if(ghosts, end, [kind](const LevelGhost& g) { return g.kind >= kind; });
+  const LevelGhost* last = std::find_if(first, end, [kind](const LevelGhost& g) { return g.kind != kind; });
+  return GhostRange{static_cast<int>(first - ghosts), static_cast<int>(last - ghosts)};
+}
+
+TileGrid Level::grid() const
+{
+  return TileGrid{width(), height(), static_cast<const uint8_t*>(section(LevelSection::tiles))};
+}
+
+TileBitsetView Level::points() const
+{
+  return TileBitsetView{width(), height(), static_cast<const uint64_t*>(section(LevelSection::points))};
+}
+
+NavMap Level::nav() const
+{
+  return NavMap{width(), height(), static_cast<const uint16_t*>(section(LevelSection::nav_cells)),
+                static_cast<int>(header().nav_cell_count),
+                header().sections[static_cast<int>(LevelSection::nav_table)].size
+                  ? static_cast<const uint16_t*>(section(LevelSection::nav_table)) : nullptr,
+                static_cast<const NavFlowTarget*>(section(LevelSection::nav_flow_targets)),
+                static_cast<const uint16_t*>(section(LevelSection::nav_flows)),
+                static_cast<int>(header().nav_flow_count)};
+}
+
+const JunctionGraph& Level::junctions() const { return *m_junctions; }
+
+TileBitsetView Level::power_ups() const
+{
+  return TileBitsetView{width(), height(), static_cast<const uint64_t*>(section(LevelSection::power_ups))};
+}
+
+int Level::point_count() const { return header().point_count; }
+
+int Level::power_up_count() const { return header().power_up_count; }
+
+const uint8_t* Level::data() const { return m_data; }
+
+std::size_t Level::size() const { return m_size; }
+
+uint64_t Level::checksum() const
+{
+  uint64_t hash {14695981039346656037u};    //64 bit FNV-1a
+  for(std::size_t i = 0; i < m_size; i++) {
+    hash ^= m_data[i];
+    hash *= 1099511628211u;
+  }
+  return hash;
+}
+
+const LevelHeader& Level::header() const
+{
+  return *reinterpret_cast<const LevelHeader*>(m_data);
+}
+
+const void* Level::section(LevelSection s) const
+{
+  return m_data + header().sections[static_cast<int>(s)].offset;
+}
+
+void Level::validate() const
+{
+  if(m_size < sizeof(LevelHeader) || std::memcmp(header().magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0)
+    throw LevelError{"not a compiled level"};
+
+  if(header().version != LEVEL_VERSION) {
+    throw LevelError{"compiled level is version " + std::to_string(header().version)
+                     + ", expected version " + std::to_string(LEVEL_VERSION)
+                     + " (rebuild it with pacman-levelc)"};
+  }
+
+  if(header().width <= 0 || header().height <= 0)
+    throw LevelError{"compiled level has no cells"};
+
+  if(header().nav_cell_count > NAV_MAX_CELLS)
+    throw LevelError{"compiled level is truncated or corrupt"};
+
+  //the size each section must have for the levels dimensions
+  const uint64_t expected_size[LEVEL_SECTION_COUNT] {
+    static_cast<uint64_t>(header().width) * header().height,
+    bitset_bytes(header().width, header().height),
+    bitset_bytes(header().width, header().height),
+    nav_cells_bytes(header().width, header().height),
+    nav_table_bytes(header().nav_cell_count),
+    static_cast<uint64_t>(header().nav_flow_count) * sizeof(NavFlowTarget),
+    static_cast<uint64_t>(header().nav_flow_count) * header().nav_cell_count * sizeof(uint16_t),
+    static_cast<uint64_t>(header().ghost_count) * sizeof(LevelGhost),
+  };
+
+  for(int i = 0; i < LEVEL_SECTION_COUNT; i++) {
+    const LevelSectionEntry& entry = header().sections[i];
+    //offset and size compared without adding them, a crafted offset near 2^64 would wrap the sum
+    if(entry.size != expected_size[i] || entry.offset % 8 != 0 || entry.offset < sizeof(LevelHeader)
+       || entry.offset > m_size || entry.size > m_size - entry.offset) {
+      throw LevelError{"compiled level is truncated or corrupt"};
+    }
+  }
+
+  //NavMap indexes fields and the table by these ids without checking them
+  const uint16_t* cell_ids = static_cast<const uint16_t*>(section(LevelSection::nav_cells));
+  const uint64_t cells = static_cast<uint64_t>(header().width) * header().height;
+  for(uint64_t i = 0; i < cells; i++) {
+    if(cell_ids[i] != NAV_NONE && cell_ids[i] >= header().nav_cell_count)
+      throw LevelError{"compiled level is truncated or corrupt"};
+  }
+
+  const NavFlowTarget* flow_targets = static_cast<const NavFlowTarget*>(section(LevelSection::nav_flow_targets));
+  for(uint32_t i = 0; i < header().nav_flow_count; i++) {
+    const NavFlowTarget& flow = flow_targets[i];
+    if(flow.target.x < 0 || flow.target.x >= header().width || flow.target.y < 0 || flow.target.y >= header().height
+       || (flow.rules != NavRules::normal && flow.rules != NavRules::eaten)) {
+      throw LevelError{"compiled level is truncated or corrupt"};
+    }
+  }
+
+  //the engines rely on the ghosts being sorted by kind, and index the grid by every stored coord
+  auto on_grid = [this](Coord coord) {
+    return coord.x >= 0 && coord.x < header().width && coord.y >= 0 && coord.y < header().height;
+  };
+
+  for(int n = 0; n < ghost_count(); n++) {
+    if(static_cast<int>(ghost(n).kind) >= GHOST_KINDS || (n > 0 && ghost(n).kind < ghost(n - 1).kind)
+       || !on_grid(ghost(n).start) || !on_grid(ghost(n).scatter)) {
+      throw LevelError{"compiled level is truncated or corrupt"};
+    }
+  }
+
+  const LevelLocations& loc = header().locations;
+  if(!on_grid(loc.pacman_start) || !on_grid(loc.left_warp) || !on_grid(loc.right_warp))
+    throw LevelError{"compiled level is truncated or corrupt"};
+
+  //the level is cleared when the points count down to 0, so the counts must match the bitsets,
+  //and bits past the last cell would be counted without being on the board
+  const uint64_t padding = cells % 64 ? ~uint64_t{0} << (cells % 64) : 0;
+  for(LevelSection bits : {LevelSection::points, LevelSection::power_ups}) {
+    const uint64_t* words = static_cast<const uint64_t*>(section(bits));
+    if(words[bitset_words(header().width, header().height) - 1] & padding)
+      throw LevelError{"compiled level is truncated or corrupt"};
+  }
+
+  if(static_cast<uint32_t>(TileBitset{points()}.count()) != header().point_count
+     || static_cast<uint32_t>(TileBitset{power_ups()}.count()) != header().power_up_count) {
+    throw LevelError{"compiled level is truncated or corrupt"};
+  }
+}
+
+void Level::build_junctions()
+{
+  const LevelLocations& loc = locations();
+  vector<Coord> starts {loc.pacman_start};
+  for(int n = 0; n < ghost_count(); n++) {
+    starts.push_back(ghost(n).start);
+  }
+  m_junctions = std::make_unique<JunctionGraph>(grid(), loc.left_warp, loc.right_warp, starts);
+}
+
+void Level::release()
+{
+  if(m_mapping) {
+    munmap(m_mapping, m_size);
+    m_mapping = nullptr;
+  }
+  m_image.clear();
+  m_junctions.reset();
+  m_data = nullptr;
+  m_size = 0;
+}
+
+/******************************* LEVEL LOADING ********************************/
+
+uint64_t level_file_checksum(const string& file, uint64_t hash)
+{
+  read_blocks(file, [&](std::string_view block) { hash = text_checksum(block, hash); });
+  return hash;
+}
+
+string read_level_file(const string& file)
+{
+  ifstream ist {file, std::ios::binary};
+  if(!ist)
+    throw LevelError{"could not open level file '" + file + "'"};
+
+  std::ostringstream contents;
+  contents << ist.rdbuf();
+  return contents.str();
+}
+
+vector<uint8_t> compile_level(const string& locations_text, const string& shapes_text)
+{
+  return compile_text(std::string_view{locations_text}, std::string_view{shapes_text});
+}
+
+vector<uint8_t> compile_level_files(const string& locations_file, const string& shapes_file)
+{
+  return compile_text(read_level_marks(locations_file), LevelFileText{shapes_file});
+}
+
+vector<uint8_t> build_level_image(const LevelLocations& locations, int width, int height, const uint8_t* tiles,
+                                  const LevelGhost* ghosts, int ghost_count)
+{
+  vector<LevelGhost> roster(ghosts, ghosts + ghost_count);
+  std::stable_sort(roster.begin(), roster.end(), [](const LevelGhost& l, const LevelGhost& r) {
+    return l.kind < r.kind;
+  });
+
+  LevelHeader header {};
+  std::memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+  header.version = LEVEL_VERSION;
+  header.width = width;
+  header.height = height;
+  header.ghost_count = ghost_count;
+  header.locations = locations;
+
+  //collect the points and power ups
+  vector<uint64_t> points(bitset_words(width, height), 0);
+  vector<uint64_t> power_ups(bitset_words(width, height), 0);
+
+  for(int index = 0; index < width * height; index++) {
+    if(tiles[index] == Tile::POINT) {
+      points[index / 64] |= uint64_t{1} << (index % 64);
+      header.point_count++;
+    } else if(tiles[index] == Tile::POWER_UP) {
+      power_ups[index / 64] |= uint64_t{1} << (index % 64);
+      header.power_up_count++;
+    }
+  }
+
+  //walk the maze from where pacman and the ghosts start, with flow fields to the
+  //ghost homes for eaten ghosts and to their scatter targets. Ghosts often share
+  //a target, each one only gets one field
+  vector<Coord> starts {locations.pacman_start};
+  vector<NavFlowTarget> flow_targets;
+
+  auto add_flow = [&flow_targets](Coord target, NavRules rules) {
+    for(const NavFlowTarget& flow : flow_targets) {
+      if(flow.target == target && flow.rules == rules)
+        return;
+    }
+    flow_targets.push_back(NavFlowTarget{target, rules, 0});
+  };
+
+  for(const LevelGhost& ghost : roster) {
+    starts.push_back(ghost.start);
+    add_flow(ghost.start, NavRules::eaten);
+  }
+  for(const LevelGhost& ghost : roster) {
+    add_flow(ghost.scatter, NavRules::normal);
+  }
+
+  NavBuild nav = build_nav(TileGrid{width, height, tiles}, locations.left_warp, locations.right_warp,
+                           starts, flow_targets);
+
+  header.nav_cell_count = nav.cell_count;
+  header.nav_flow_count = nav.flow_targets.size();
+
+  //lay out the sections after the header
+  const void* section_data[LEVEL_SECTION_COUNT] {
+    tiles, points.data(), power_ups.data(),
+    nav.cell_ids.data(), nav.table.data(), nav.flow_targets.data(), nav.flows.data(),
+    roster.data(),
+  };
+
+  const uint64_t section_size[LEVEL_SECTION_COUNT] {
+    static_cast<uint64_t>(width) * height,
+    points.size() * sizeof(uint64_t),
+    power_ups.size() * sizeof(uint64_t),
+    nav.cell_ids.size() * sizeof(uint16_t),
+    nav.table.size() * sizeof(uint16_t),
+    nav.flow_targets.size() * sizeof(NavFlowTarget),
+    nav.flows.size() * sizeof(uint16_t),
+    roster.size() * sizeof(LevelGhost),
+  };
+
+  uint64_t offset = align(sizeof(LevelHeader));
+  for(int i = 0; i < LEVEL_SECTION_COUNT; i++) {
+    header.sections[i] = LevelSectionEntry{offset, section_size[i]};
+    offset = align(offset + section_size[i]);
+  }
+
+  vector<uint8_t> image(offset, 0);
+
+  for(int i = 0; i < LEVEL_SECTION_COUNT; i++) {
+    if(section_size[i])
+      std::memcpy(image.data() + header.sections[i].offset, section_data[i], section_size[i]);
+  }
+
+  std::memcpy(image.data(), &header, sizeof(LevelHeader));
+  return image;
+}
+
+Level parse_level(const string& locations_text, const string& shapes_text)
+{
+  return Level::from_image(compile_level(locations_text, shapes_text));
+}
+
+Level load_level(const string& locations_file, const string& shapes_file)
+{
+  return Level::from_image(compile_level_files(locations_file, shapes_file));
+}
@@ -0,0 +1,50 @@
+#include "level.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+
+/*
+ * pacman-levelc compiles a levels text files into the binary level image
+ * that pacman maps at startup.
+ *
+ *   pacman-levelc <locations file> <shapes file> <output file>
+ */
+
+int main(int argc, char* argv[])
+{
+  if(argc != 4) {
+    std::cerr << "usage: pacman-levelc <locations file> <shapes file> <output file>\n";
+    return 2;
+  }
+
+  const std::string output {argv[3]};
+  const std::string temp {output + ".tmp"};
+
+  try {
+    Level level = load_level(argv[1], argv[2]);
+
+    //write to a temp file then rename it, so a running game never maps a half written level
+    std::ofstream ost {temp, std::ios::binary | std::ios::trunc};
+    ost.write(reinterpret_cast<const char*>(level.data()), level.size());
+    ost.close();
+    if(!ost)
+      throw LevelError{"could not write '" + temp + "'"};
+
+    if(std::rename(temp.c_str(), output.c_str()) != 0)
+      throw LevelError{"could not rename '" + temp + "' to '" + output + "'"};
+
+    std::cout << output << ": " << level.width() << "x" << level.height() << " tiles, "
+              << level.point_count() << " points, " << level.power_up_count() << " power ups, "
+              << level.ghost_count() << " ghosts, " << level.nav().cell_count() << " nav cells" << (level.nav().has_table() ? "" : " (no distance table)")
+              << ", " << level.junctions().junctions().size() << " junctions, "
+              << level.junctions().corridor_cells() << " corridor cells, " << level.size() << " bytes\n";
+  } catch(const LevelError& e) {
+    std::remove(temp.c_str());
+    std::cerr << "pacman-levelc: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
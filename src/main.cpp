@@ -1,8 +1,315 @@
 #include "game.h"
+#include "backend.h"
+#include "screen.h"
+#include "level.h"
+#include "pack.h"
+#include "watch.h"
+#include "replay.h"
+#include "metrics.h"
+#include "config.h"
 
-int main()
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <stdexcept>
+#include <random>
+#include <cstdint>
+#include <optional>
+#include <memory>
+
+using std::string;
+
+namespace
+{
+  constexpr const char* USAGE {"usage: pacman [--headless] [--ticks n] [--tick-ms n] [--seed n]\n"
+                               "              [--record file | --replay file]\n"
+                               "              [--profile-csv file] [--profile-trace file] [--metrics-socket path]\n"
+                               "              [--level file | --level-text locations shapes | --level-pack manifest] [--watch]\n"
+                               "  --headless     run the game with no terminal and no pauses\n"
+                               "  --ticks n      stop after n ticks (headless default: 1000000)\n"
+                               "  --tick-ms n    tick period in milliseconds (default: 190, + and - change it in game)\n"
+                               "  --seed n       seed for the ghosts random moves (default: random)\n"
+                               "  --record file  record every ticks input and state hash to a replay file\n"
+                               "  --replay file  play a replay back and check its state hashes,\n"
+                               "                 at real speed, or unthrottled with --headless\n"
+                               "  --profile-csv file    write each ticks phase timings as CSV (make PROFILE=1 builds)\n"
+                               "  --profile-trace file  write each ticks phase timings as Chrome trace JSON\n"
+                               "  --metrics-socket path serve Prometheus text metrics on a Unix socket at path\n"
+                               "  --level file   play a level compiled by pacman-levelc on every level, not the built in mazes\n"
+                               "  --level-text locations shapes  play a level from its text files on every level\n"
+                               "  --level-pack manifest  play the mazes a manifest lists, one after another\n"
+                               "  --watch        reload a maze when its files are saved, not with --record or --replay\n"};
+
+  //the recording or replay wrapped around a runs backend
+  struct Harness
+  {
+    std::optional<Replay> recording;
+    std::optional<Replay> replay;
+
+    std::optional<RecordingBackend> recorder;
+    std::optional<ReplayBackend> replayer;
+
+    //wrap backend in the recorder or the replayer, if there is one
+    Backend& wrap(Backend& backend)
+    {
+      if(recording)
+        return recorder.emplace(backend, *recording);
+      if(replay)
+        return replayer.emplace(backend, *replay);
+      return backend;
+    }
+  };
+
+  //a compiled level, level text files or a level pack given in place of the built in mazes
+  struct LevelOverride
+  {
+    string compiled;
+    string locations;
+    string shapes;
+    string pack;
+  };
+
+  //the built in mazes, unless others were given
+  std::shared_ptr<LevelPack> load(const LevelOverride& level)
+  {
+    if(!level.compiled.empty())
+      return LevelPack::compiled_level(level.compiled);
+    if(!level.locations.empty())
+      return LevelPack::text_level(level.locations, level.shapes);
+    if(!level.pack.empty())
+      return LevelPack::load(level.pack);
+    return LevelPack::built_in();
+  }
+
+  //run the game with no terminal and report how fast it ticked
+  void run_headless(const std::shared_ptr<LevelPack>& levels, const GameOptions& options, Harness& harness)
+  {
+    NullBackend backend;
+    Game game {levels, harness.wrap(backend), options};
+
+    auto start = std::chrono::steady_clock::now();
+    game.run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "seed: " << game.core().seed() << "\n"
+              << "ticks: " << game.ticks() << "\n"
+              << "seconds: " << elapsed.count() << "\n"
+              << "ticks per second: " << static_cast<long>(game.ticks() / elapsed.count()) << "\n"
+              << "games played: " << game.games_played() << "\n"
+              << "level: " << game.core().level() << "\n"
+              << "score: " << game.core().pacman().points() << "\n";
+
+#ifdef PACMAN_PROFILE
+    if(game.profiler().dropped() > 0)
+      std::cerr << "pacman: profiler dropped " << game.profiler().dropped() << " samples, the writer fell behind\n";
+#endif
+  }
+
+  //run the game on the terminal and report how well the clock kept time
+  void run_terminal(const std::shared_ptr<LevelPack>& levels, const GameOptions& options, Harness& harness)
+  {
+    long missed {0};
+    long dropped {0};
+    long max_late {0};
+
+    {
+      NcursesBackend backend {options.metrics};
+      Game game {levels, harness.wrap(backend), options};
+      game.run();
+
+      missed = game.clock().missed();
+      dropped = game.clock().dropped();
+      max_late = game.clock().max_late().count();
+    }   //end ncurses before printing the report
+
+    std::cerr << "pacman: " << missed << " missed tick deadlines, " << dropped
+              << " dropped ticks, worst " << max_late << " us late\n";
+  }
+
+  //report how the replay went, returns false if the game diverged from it
+  bool check_replay(const Harness& harness)
+  {
+    const ReplayBackend& replayer = *harness.replayer;
+
+    if(replayer.diverged()) {
+      long tick = replayer.diverged_tick();
+      std::cerr << "pacman: replay diverged at tick " << tick << ", expected hash "
+                << std::hex << harness.replay->hash(tick) << " got " << replayer.diverged_hash()
+                << std::dec << "\n";
+      return false;
+    }
+
+    std::cerr << "pacman: replay matched " << replayer.ticks_checked() << " of "
+              << harness.replay->ticks() << " ticks\n";
+    return true;
+  }
+}
+
+int main(int argc, char* argv[])
 {
-  Game game;
-  game.run();
+  bool headless {false};
+  bool seeded {false};
+  bool watch {false};
+  GameOptions options;
+  string record_file;
+  string replay_file;
+  string metrics_socket;
+  LevelOverride level_override;
+
+  try {
+    for(int i = 1; i < argc; i++) {
+      string arg {argv[i]};
+      if(arg == "--headless") {
+        headless = true;
+      } else if(arg == "--ticks" && i + 1 < argc) {
+        options.max_ticks = std::stol(argv[++i]);
+      } else if(arg == "--tick-ms" && i + 1 < argc) {
+        options.tick_ms = std::stoi(argv[++i]);
+      } else if(arg == "--seed" && i + 1 < argc) {
+        options.seed = std::stoull(argv[++i]);
+        seeded = true;
+      } else if(arg == "--record" && i + 1 < argc && replay_file.empty()) {
+        record_file = argv[++i];
+      } else if(arg == "--replay" && i + 1 < argc && record_file.empty()) {
+        replay_file = argv[++i];
+      } else if(arg == "--level" && i + 1 < argc && level_override.locations.empty() && level_override.pack.empty()) {
+        level_override.compiled = argv[++i];
+      } else if(arg == "--level-text" && i + 2 < argc && level_override.compiled.empty() && level_override.pack.empty()) {
+        level_override.locations = argv[++i];
+        level_override.shapes = argv[++i];
+      } else if(arg == "--level-pack" && i + 1 < argc && level_override.compiled.empty() && level_override.locations.empty()) {
+        level_override.pack = argv[++i];
+      } else if(arg == "--watch") {
+        watch = true;
+      } else if(arg == "--metrics-socket" && i + 1 < argc) {
+        metrics_socket = argv[++i];
+      } else if(arg == "--profile-csv" && i + 1 < argc) {
+        options.profile_csv = argv[++i];
+      } else if(arg == "--profile-trace" && i + 1 < argc) {
+        options.profile_trace = argv[++i];
+      } else {
+        throw std::invalid_argument{arg};
+      }
+    }
+    if(options.max_ticks < 0 || options.tick_ms <= 0)
+      throw std::invalid_argument{"negative"};
+    if(watch && (!record_file.empty() || !replay_file.empty()))
+      throw std::invalid_argument{"reloads aren't recorded"};
+  } catch(const std::logic_error&) {    //bad option or number
+    std::cerr << USAGE;
+    return 2;
+  }
+
+#ifndef PACMAN_PROFILE
+  if(!options.profile_csv.empty() || !options.profile_trace.empty()) {
+    std::cerr << "pacman: built without profiling, rebuild with make PROFILE=1\n";
+    return 2;
+  }
+#endif
+
+  Harness harness;
+
+  if(!replay_file.empty()) {
+    try {
+      harness.replay = Replay::load(replay_file);
+    } catch(const ReplayError& e) {
+      std::cerr << "pacman: " << e.what() << "\n";
+      return 1;
+    }
+    options.seed = harness.replay->seed();     //the replay plays until its last tick
+    seeded = true;
+  }
+
+  if(!seeded)
+    options.seed = (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+
+  if(headless) {
+    options.throttle = false;
+    if(options.max_ticks == 0 && !harness.replay)
+      options.max_ticks = GameConfig::HEADLESS_TICKS;
+  }
+
+  //load the level before starting ncurses, so errors print to a normal terminal
+  auto load_start = std::chrono::steady_clock::now();
+
+  std::shared_ptr<LevelPack> levels;
+  std::uint64_t levels_checksum;
+  try {
+    levels = load(level_override);
+    levels->level(GameConfig::STARTING_LEVEL);     //the first maze, the rest are prefetched as the game goes
+    levels_checksum = levels->checksum();
+  } catch(const LevelError& e) {
+    std::cerr << "pacman: " << e.what() << "\n";
+    return 1;
+  }
+
+  auto load_time = std::chrono::steady_clock::now() - load_start;
+  std::cerr << "pacman: loaded level in "
+            << std::chrono::duration_cast<std::chrono::microseconds>(load_time).count() << " us\n";
+
+  if(harness.replay && harness.replay->level_checksum() != levels_checksum) {
+    std::cerr << "pacman: '" << replay_file << "' was recorded on a different level\n";
+    return 1;
+  }
+
+  if(!record_file.empty())
+    harness.recording.emplace(options.seed, levels_checksum);
+
+  //served from its own thread for as long as the game runs
+  std::unique_ptr<Metrics> metrics;
+  std::unique_ptr<MetricsServer> metrics_server;
+
+  if(!metrics_socket.empty()) {
+    try {
+      metrics = std::make_unique<Metrics>();
+      metrics_server = std::make_unique<MetricsServer>(*metrics, metrics_socket);
+    } catch(const MetricsError& e) {
+      std::cerr << "pacman: " << e.what() << "\n";
+      return 1;
+    }
+    options.metrics = metrics.get();
+  }
+
+  //reloads edited mazes on its own thread, the game swaps them in between ticks
+  std::unique_ptr<LevelWatcher> watcher;
+
+  if(watch) {
+    try {
+      watcher = std::make_unique<LevelWatcher>(levels);
+    } catch(const WatchError& e) {
+      std::cerr << "pacman: " << e.what() << "\n";
+      return 1;
+    }
+    options.watcher = watcher.get();
+  }
+
+  try {
+    if(headless)
+      run_headless(levels, options, harness);
+    else
+      run_terminal(levels, options, harness);
+  } catch(const LevelError& e) {    //a maze further into the pack that failed to load
+    std::cerr << "pacman: " << e.what() << "\n";
+    return 1;
+  }
+#ifdef PACMAN_PROFILE
+  catch(const ProfileError& e) {
+    std::cerr << "pacman: " << e.what() << "\n";
+    return 1;
+  }
+#endif
+
+  if(harness.recording) {
+    try {
+      harness.recording->save(record_file);
+    } catch(const ReplayError& e) {
+      std::cerr << "pacman: " << e.what() << "\n";
+      return 1;
+    }
+  }
+
+  if(harness.replay && !check_replay(harness))
+    return 1;
+
   return 0;
 }
@@ -0,0 +1,203 @@
+#include "metrics.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using std::string;
+using std::uint64_t;
+
+namespace
+{
+  constexpr int ACCEPT_POLL_MS {200};     //how often the server checks if it should stop
+  constexpr int REQUEST_WAIT_MS {100};    //how long to wait for a request before answering anyway
+  constexpr double NS {1e-9};             //seconds per nanosecond
+
+  //one # HELP and # TYPE header
+  void header(string& out, const char* name, const char* type, const char* help)
+  {
+    out += string{"# HELP "} + name + " " + help + "\n";
+    out += string{"# TYPE "} + name + " " + type + "\n";
+  }
+
+  //a number the way prometheus reads it
+  string number(double value)
+  {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    return text;
+  }
+
+  //a histogram with a line for each bucket that has values, scaled into the metrics unit
+  void histogram(string& out, const char* name, const char* help, const Histogram& h, double scale)
+  {
+    header(out, name, "histogram", help);
+
+    uint64_t cumulative {0};
+    for(int i = 0; i < Histogram::BUCKETS; i++) {
+      uint64_t n = h.bucket(i);
+      if(n == 0)
+        continue;
+      cumulative += n;
+      out += string{name} + "_bucket{le=\"" + number(Histogram::bucket_max(i) * scale) + "\"} "
+             + std::to_string(cumulative) + "\n";
+    }
+
+    //count from the buckets, so +Inf always matches them even while the game records
+    out += string{name} + "_bucket{le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+    out += string{name} + "_sum " + number(h.sum() * scale) + "\n";
+    out += string{name} + "_count " + std::to_string(cumulative) + "\n";
+  }
+
+  void counter(string& out, const char* name, const char* help, const Counter& c)
+  {
+    header(out, name, "counter", help);
+    out += string{name} + " " + std::to_string(c.value()) + "\n";
+  }
+}
+
+/********************************** HISTOGRAM **********************************/
+
+void Histogram::record(uint64_t value)
+{
+  m_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::count() const { return m_count.load(std::memory_order_relaxed); }
+
+uint64_t Histogram::sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+uint64_t Histogram::bucket(int index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+
+int Histogram::bucket_index(uint64_t value)
+{
+  if(value < SUB_BUCKETS)
+    return value;
+
+  //the power of 2 picks the bucket group, the next SUB_BITS bits the sub-bucket
+  int power = 63 - __builtin_clzll(value);
+  int sub = (value >> (power - SUB_BITS)) & (SUB_BUCKETS - 1);
+  return SUB_BUCKETS + (power - SUB_BITS) * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucket_max(int index)
+{
+  if(index < SUB_BUCKETS)
+    return index;
+
+  int power = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+  uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+  int shift = power - SUB_BITS;
+  return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+/*********************************** METRICS ***********************************/
+
+string Metrics::exposition() const
+{
+  string out;
+
+  histogram(out, "pacman_tick_duration_seconds",
+            "Time to run a tick with no animation or prompt, not counting the wait for the next one.", tick_ns, NS);
+  histogram(out, "pacman_render_duration_seconds", "Time to draw a frame.", render_ns, NS);
+  histogram(out, "pacman_input_to_move_seconds", "Time from reading a move key to drawing the frame pacman moved in.",
+            input_to_move_ns, NS);
+  histogram(out, "pacman_terminal_write_bytes", "Bytes written to the terminal for each frame.",
+            terminal_write_bytes, 1);
+
+  counter(out, "pacman_ticks_total", "Ticks run.", ticks);
+  counter(out, "pacman_pellets_eaten_total", "Points eaten by pacman.", pellets_eaten);
+  counter(out, "pacman_power_ups_eaten_total", "Power ups eaten by pacman.", power_ups_eaten);
+  counter(out, "pacman_ghosts_eaten_total", "Ghosts eaten by pacman.", ghosts_eaten);
+  counter(out, "pacman_deaths_total", "Times pacman was eaten.", deaths);
+  counter(out, "pacman_level_resets_total", "Times the board was reset for a new level or a new game.", level_resets);
+
+  return out;
+}
+
+/******************************** METRICSSERVER ********************************/
+
+MetricsServer::MetricsServer(const Metrics& metrics, const string& socket_path)
+  : m_metrics {metrics}, m_path {socket_path}
+{
+  sockaddr_un address {};
+  address.sun_family = AF_UNIX;
+  if(m_path.size() >= sizeof(address.sun_path))
+    throw MetricsError{"socket path '" + m_path + "' is too long"};
+  std::strcpy(address.sun_path, m_path.c_str());
+
+  m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(m_socket < 0)
+    throw MetricsError{string{"can't create the metrics socket: "} + std::strerror(errno)};
+
+  unlink(m_path.c_str());     //a socket left behind by an earlier run
+
+  if(bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+     || listen(m_socket, 8) < 0) {
+    string error = std::strerror(errno);
+    close(m_socket);
+    throw MetricsError{"can't listen on '" + m_path + "': " + error};
+  }
+
+  m_thread = std::thread {&MetricsServer::serve, this};
+}
+
+MetricsServer::~MetricsServer()
+{
+  m_stop = true;
+  m_thread.join();
+
+  close(m_socket);
+  unlink(m_path.c_str());
+}
+
+void MetricsServer::serve()
+{
+  while(!m_stop) {
+    pollfd listener {m_socket, POLLIN, 0};
+    if(poll(&listener, 1, ACCEPT_POLL_MS) <= 0)
+      continue;
+
+    int client = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+    if(client < 0)
+      continue;
+
+    respond(client);
+    close(client);
+  }
+}
+
+void MetricsServer::respond(int client)
+{
+  //read whatever request was sent, an HTTP GET or nothing at all
+  pollfd request {client, POLLIN, 0};
+  if(poll(&request, 1, REQUEST_WAIT_MS) > 0) {
+    char discard[4096];
+    if(recv(client, discard, sizeof(discard), 0) < 0)
+      return;
+  }
+
+  string body = m_metrics.exposition();
+  string response = "HTTP/1.0 200 OK\r\n"
+                    "Content-Type: text/plain; version=0.0.4\r\n"
+                    "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                    "\r\n" + body;
+
+  std::size_t sent {0};
+  while(sent < response.size()) {
+    ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+    if(n <= 0)
+      return;
+    sent += n;
+  }
+}
@@ -0,0 +1,191 @@
+#include "nav.h"
+#include "coord.h"
+#include "grid.h"
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+using std::vector;
+using std::uint16_t;
+
+namespace
+{
+  //the cells a ghost at coord can move to under rules, warps already taken
+  template<typename F>
+  void for_each_move(TileGrid grid, Coord coord, NavRules rules, Coord left_warp, Coord right_warp, F f)
+  {
+    const Coord moves[4] {coord + Coord{2,0}, coord + Coord{0,1}, coord + Coord{-2,0}, coord + Coord{0,-1}};
+
+    for(int i = 0; i < 4; i++) {
+      Coord next = moves[i];
+      if(!grid.in_bounds(next) || grid.is_border(next))
+        continue;
+
+      bool down = i == 1;
+      bool up = i == 3;
+      if(grid.is_inv_wall(next) && !up && !(down && rules == NavRules::eaten))
+        continue;
+
+      if(next == left_warp)
+        next = right_warp;
+      else if(next == right_warp)
+        next = left_warp;
+
+      f(next);
+    }
+  }
+
+  //fill field with the moves from every cell to target, walking the reversed moves
+  void fill_field(const vector<vector<uint16_t>>& reversed, int target, uint16_t* field)
+  {
+    std::fill(field, field + reversed.size(), NAV_NONE);
+
+    vector<uint16_t> queue;
+    queue.reserve(reversed.size());
+    queue.push_back(target);
+    field[target] = 0;
+
+    for(std::size_t head = 0; head < queue.size(); head++) {
+      uint16_t cell = queue[head];
+      for(uint16_t from : reversed[cell]) {
+        if(field[from] == NAV_NONE) {
+          field[from] = field[cell] + 1;
+          queue.push_back(from);
+        }
+      }
+    }
+  }
+}
+
+/********************************** NAVMAP ***********************************/
+
+NavMap::NavMap(int width, int height, const uint16_t* cell_ids, int cell_count,
+               const uint16_t* table, const NavFlowTarget* flow_targets,
+               const uint16_t* flows, int flow_count)
+  :
+  m_width {width},
+  m_height {height},
+  m_cell_ids {cell_ids},
+  m_cell_count {cell_count},
+  m_table {table},
+  m_flow_targets {flow_targets},
+  m_flows {flows},
+  m_flow_count {flow_count}
+{}
+
+int NavMap::cell_count() const { return m_cell_count; }
+
+bool NavMap::has_table() const { return m_table != nullptr; }
+
+int NavMap::cell(Coord coord) const
+{
+  if(!m_cell_ids || coord.x < 0 || coord.x >= m_width || coord.y < 0 || coord.y >= m_height)
+    return -1;
+  uint16_t id = m_cell_ids[coord.y * m_width + coord.x];
+  return id == NAV_NONE ? -1 : id;
+}
+
+const uint16_t* NavMap::field(Coord target, NavRules rules) const
+{
+  for(int i = 0; i < m_flow_count; i++) {
+    if(m_flow_targets[i].target == target && m_flow_targets[i].rules == rules)
+      return m_flows + static_cast<std::size_t>(i) * m_cell_count;
+  }
+
+  int id = cell(target);
+  if(m_table && rules == NavRules::normal && id >= 0)
+    return m_table + static_cast<std::size_t>(id) * m_cell_count;
+
+  return nullptr;
+}
+
+int NavMap::distance(const uint16_t* field, Coord coord) const
+{
+  int id = cell(coord);
+  return id < 0 ? NAV_NONE : field[id];
+}
+
+int NavMap::path_distance(Coord from, Coord to) const
+{
+  const uint16_t* to_field = field(to, NavRules::normal);
+  if(!to_field)
+    return -1;
+  return distance(to_field, from);
+}
+
+/********************************* NAV BUILD *********************************/
+
+NavBuild build_nav(TileGrid grid, Coord left_warp, Coord right_warp,
+                   const vector<Coord>& starts, const vector<NavFlowTarget>& flow_targets)
+{
+  NavBuild nav;
+  nav.cell_ids.assign(static_cast<std::size_t>(grid.width()) * grid.height(), NAV_NONE);
+
+  auto id_of = [&](Coord coord) -> uint16_t& { return nav.cell_ids[coord.y * grid.width() + coord.x]; };
+
+  //find the cells, with the eaten rules since they reach the most cells
+  vector<Coord> cells;
+  for(Coord start : starts) {
+    if(grid.in_bounds(start) && !grid.is_border(start) && id_of(start) == NAV_NONE) {
+      id_of(start) = cells.size();
+      cells.push_back(start);
+    }
+  }
+
+  for(std::size_t head = 0; head < cells.size(); head++) {
+    for_each_move(grid, cells[head], NavRules::eaten, left_warp, right_warp, [&](Coord next) {
+      if(grid.in_bounds(next) && id_of(next) == NAV_NONE && static_cast<int>(cells.size()) < NAV_MAX_CELLS + 1) {
+        id_of(next) = cells.size();
+        cells.push_back(next);
+      }
+    });
+  }
+
+  if(static_cast<int>(cells.size()) > NAV_MAX_CELLS) {     //too big, leave the ghosts to straight lines
+    std::fill(nav.cell_ids.begin(), nav.cell_ids.end(), NAV_NONE);
+    return nav;
+  }
+
+  //stepping onto a warp lands on the other one
+  if(grid.in_bounds(left_warp) && grid.in_bounds(right_warp)) {
+    if(id_of(left_warp) == NAV_NONE)
+      id_of(left_warp) = id_of(right_warp);
+    if(id_of(right_warp) == NAV_NONE)
+      id_of(right_warp) = id_of(left_warp);
+  }
+
+  const int n = cells.size();
+  nav.cell_count = n;
+
+  //the moves into each cell, for each set of rules
+  vector<vector<uint16_t>> reversed[2] {vector<vector<uint16_t>>(n), vector<vector<uint16_t>>(n)};
+  for(NavRules rules : {NavRules::normal, NavRules::eaten}) {
+    vector<vector<uint16_t>>& into = reversed[static_cast<int>(rules)];
+    for(int from = 0; from < n; from++) {
+      for_each_move(grid, cells[from], rules, left_warp, right_warp, [&](Coord next) {
+        uint16_t to = grid.in_bounds(next) ? id_of(next) : NAV_NONE;
+        if(to != NAV_NONE)
+          into[to].push_back(from);
+      });
+    }
+  }
+
+  if(n <= NAV_MAX_TABLE_CELLS) {
+    nav.table.resize(static_cast<std::size_t>(n) * n);
+    for(int target = 0; target < n; target++) {
+      fill_field(reversed[static_cast<int>(NavRules::normal)], target, &nav.table[static_cast<std::size_t>(target) * n]);
+    }
+  }
+
+  //flow fields, skipping targets no ghost can reach
+  for(const NavFlowTarget& flow : flow_targets) {
+    if(!grid.in_bounds(flow.target) || id_of(flow.target) == NAV_NONE)
+      continue;
+    nav.flow_targets.push_back(flow);
+    nav.flows.resize(nav.flow_targets.size() * n);
+    fill_field(reversed[static_cast<int>(flow.rules)], id_of(flow.target), &nav.flows[nav.flows.size() - n]);
+  }
+
+  return nav;
+}
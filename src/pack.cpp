@@ -0,0 +1,279 @@
+#include "pack.h"
+#include "level.h"
+#include "config.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <cstdint>
+
+#include <unistd.h>
+
+using std::string;
+using std::vector;
+using std::uint64_t;
+
+namespace
+{
+  //the directory a file is in, with a trailing slash, or "" for the working directory
+  string directory_of(const string& file)
+  {
+    std::size_t slash = file.rfind('/');
+    return slash == string::npos ? "" : file.substr(0, slash + 1);
+  }
+
+  //a path from a manifest, relative to the manifests directory unless its absolute
+  string resolve(const string& directory, const string& path)
+  {
+    return path[0] == '/' ? path : directory + path;
+  }
+
+  //fold a mazes checksum into the packs
+  uint64_t combine(uint64_t hash, uint64_t maze_checksum)
+  {
+    for(int i = 0; i < 8; i++) {
+      hash ^= static_cast<std::uint8_t>(maze_checksum >> (i * 8));
+      hash *= 1099511628211u;
+    }
+    return hash;
+  }
+}
+
+/********************************** LEVELPACK **********************************/
+
+LevelPack::LevelPack(vector<Source> sources)
+  :
+  m_sources {std::move(sources)},
+  m_loaded(m_sources.size()),
+  m_reloads(m_sources.size())
+{}
+
+LevelPack::~LevelPack()
+{
+  //the loader thread locks m_mutex, so let it finish before any member goes
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    m_stop = true;
+  }
+  m_wake.notify_one();
+
+  if(m_loader.joinable())
+    m_loader.join();
+}
+
+std::shared_ptr<LevelPack> LevelPack::built_in()
+{
+  vector<Source> sources;
+  for(int i = 0; i < embedded_level_count(); i++) {
+    Source source;
+    source.embedded = i;
+    sources.push_back(source);
+  }
+  return std::shared_ptr<LevelPack>{new LevelPack{std::move(sources)}};
+}
+
+std::shared_ptr<LevelPack> LevelPack::compiled_level(const string& file)
+{
+  Source source;
+  source.compiled = file;
+  return std::shared_ptr<LevelPack>{new LevelPack{{source}}};
+}
+
+std::shared_ptr<LevelPack> LevelPack::text_level(const string& locations, const string& shapes)
+{
+  Source source;
+  source.locations = locations;
+  source.shapes = shapes;
+  return std::shared_ptr<LevelPack>{new LevelPack{{source}}};
+}
+
+std::shared_ptr<LevelPack> LevelPack::load(const string& manifest)
+{
+  std::istringstream lines {read_level_file(manifest)};
+  string directory = directory_of(manifest);
+
+  vector<Source> sources;
+
+  string line;
+  for(int n = 1; std::getline(lines, line); n++) {
+    std::istringstream words {line};
+    vector<string> files;
+    for(string word; words >> word; )
+      files.push_back(word);
+
+    if(files.empty() || files[0][0] == '#')
+      continue;
+
+    Source source;
+    if(files.size() == 1) {
+      source.compiled = resolve(directory, files[0]);
+    } else if(files.size() == 2) {
+      source.locations = resolve(directory, files[0]);
+      source.shapes = resolve(directory, files[1]);
+    } else {
+      throw LevelError{"'" + manifest + "' line " + std::to_string(n)
+                       + ": expected a compiled level, or a locations and a shapes file"};
+    }
+
+    //catch a missing file now, rather than when the game gets to its level
+    for(const string* file : {&source.compiled, &source.locations, &source.shapes}) {
+      if(!file->empty() && access(file->c_str(), R_OK) != 0)
+        throw LevelError{"'" + manifest + "' line " + std::to_string(n) + ": could not open level file '" + *file + "'"};
+    }
+
+    sources.push_back(source);
+  }
+
+  if(sources.empty())
+    throw LevelError{"'" + manifest + "' lists no levels"};
+
+  return std::shared_ptr<LevelPack>{new LevelPack{std::move(sources)}};
+}
+
+int LevelPack::size() const { return m_sources.size(); }
+
+int LevelPack::maze(int game_level) const
+{
+  return (game_level - GameConfig::STARTING_LEVEL) % size();
+}
+
+SharedLevel LevelPack::level(int game_level)
+{
+  int i = maze(game_level);
+  int reloads;
+  std::shared_future<SharedLevel> pending;
+
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    if(SharedLevel level = m_loaded[i].lock())
+      return level;
+    if(m_prefetch.valid() && m_prefetch_index == i)
+      pending = m_prefetch;
+    reloads = m_reloads[i];
+  }
+
+  if(pending.valid())
+    return pending.get();     //wait for the prefetch, throws the LevelError it failed with
+
+  //nobody asked for this maze ahead of time, load it here
+  SharedLevel level = load_maze(i);
+  keep(i, level, reloads);
+  return level;
+}
+
+void LevelPack::prefetch(int game_level)
+{
+  int i = maze(game_level);
+
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    if(!m_loaded[i].expired() || (m_prefetch.valid() && m_prefetch_index == i))
+      return;
+
+    //a replaced prefetch still loads, level() may be waiting on it
+    Prefetch job {i, m_reloads[i], {}};
+    m_prefetch_index = i;
+    m_prefetch = job.result.get_future().share();
+    m_queue.push_back(std::move(job));
+
+    if(!m_loader.joinable())
+      m_loader = std::thread {&LevelPack::load_prefetches, this};
+  }
+  m_wake.notify_one();
+}
+
+vector<string> LevelPack::files(int maze) const
+{
+  const Source& source = m_sources[maze];
+
+  if(!source.compiled.empty())
+    return {source.compiled};
+  if(!source.locations.empty())
+    return {source.locations, source.shapes};
+  return {};
+}
+
+SharedLevel LevelPack::reload(int maze)
+{
+  SharedLevel level = load_maze(maze);
+
+  std::lock_guard<std::mutex> lock {m_mutex};
+  m_reloads[maze]++;                  //a load started before this one wont replace it
+  m_loaded[maze] = level;
+  if(maze == 0)
+    m_first = level;
+  if(m_prefetch_index == maze)
+    m_prefetch_index = -1;            //level() waits on it no more, the loader thread still finishes it
+  return level;
+}
+
+uint64_t LevelPack::checksum()
+{
+  if(size() == 1)
+    return level(GameConfig::STARTING_LEVEL)->checksum();
+
+  uint64_t hash {14695981039346656037u};
+  for(const Source& source : m_sources) {
+    if(source.embedded >= 0) {
+      hash = combine(hash, embedded_level_checksum(source.embedded));
+    } else if(!source.compiled.empty()) {
+      hash = combine(hash, level_file_checksum(source.compiled));    //the same as Level::checksum
+    } else {
+      hash = combine(hash, level_file_checksum(source.shapes, level_file_checksum(source.locations)));
+    }
+  }
+  return hash;
+}
+
+SharedLevel LevelPack::load_maze(int index) const
+{
+  const Source& source = m_sources[index];
+
+  if(source.embedded >= 0)
+    return std::make_shared<const Level>(embedded_level(source.embedded));
+  if(!source.compiled.empty())
+    return std::make_shared<const Level>(Level::map_file(source.compiled));
+  return std::make_shared<const Level>(load_level(source.locations, source.shapes));
+}
+
+void LevelPack::keep(int index, const SharedLevel& level, int reloads)
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+  if(reloads != m_reloads[index])
+    return;             //the maze was reloaded while this loaded, from older files
+  m_loaded[index] = level;
+  if(index == 0)
+    m_first = level;
+}
+
+void LevelPack::load_prefetches()
+{
+  std::unique_lock<std::mutex> lock {m_mutex};
+
+  while(true) {
+    m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    if(m_stop)
+      return;     //a prefetch left in the queue breaks its promise, nobody is left to wait on it
+
+    Prefetch job = std::move(m_queue.front());
+    m_queue.pop_front();
+
+    lock.unlock();
+    try {
+      SharedLevel level = load_maze(job.index);
+      keep(job.index, level, job.reloads);
+      job.result.set_value(level);
+    } catch(...) {
+      job.result.set_exception(std::current_exception());    //level() throws it
+    }
+    lock.lock();
+  }
+}
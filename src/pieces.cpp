@@ -1,42 +1,57 @@
 #include "pieces.h"
 #include "coord.h"
 #include "config.h"
-#include "game.h"
+#include "core.h"
+#include "canvas.h"
 
-#include <list>
-#include <stdlib.h>
-#include <ncurses.h>
+#include <utility>
 
-using std::list;
+namespace
+{
+  //the symbols each kind of ghost is drawn with, indexed by GhostKind
+  struct GhostLook
+  {
+    char chase;
+    char frightened;
+  };
+
+  constexpr GhostLook GHOST_LOOKS[GHOST_KINDS] {
+    {Symbols::BLINKY, Symbols::BLINKY_FRIGHTENED},
+    {Symbols::PINKY, Symbols::PINKY_FRIGHTENED},
+    {Symbols::CLYDE, Symbols::CLYDE_FRIGHTENED},
+    {Symbols::INKY, Symbols::INKY_FRIGHTENED},
+  };
+}
 
 /********************************** PIECE ***********************************/
 
-Piece::Piece(Coord location, list<Coord> shape, char symbol)
+Piece::Piece(Coord location, Shape shape, char symbol)
   :
   m_location {location},
   m_shape {shape},
   m_symbol {symbol}
 {}
 
-const list<Coord>& Piece::shape() const { return m_shape; }
+Shape Piece::shape() const { return m_shape; }
 
 Coord Piece::location() const { return m_location; }
 
-char Piece::symbol() const { return *m_blinker[0]; }
+char Piece::symbol() const { return m_blinked ? Symbols::INVISIBLE : m_symbol; }
+
+unsigned Piece::revision() const { return m_revision; }
 
-void Piece::draw(WINDOW* w)
+void Piece::draw(Canvas& canvas)
 {
   for(Coord coord : m_shape) {                       //for each coord in shape
     Coord location = coord + m_location;             //calc window location
-    mvwaddch(w, location.y, location.x, symbol());   //draw the symbol onto window
+    canvas.put(location, symbol());                  //draw the symbol onto canvas
   }
 }
 
 void Piece::blink()
 {
-  const char* temp = m_blinker[0];
-  m_blinker[0] = m_blinker[1];
-  m_blinker[1] = temp;
+  m_blinked = !m_blinked;
+  changed();
 }
 
 bool Piece::in(const Piece* other)
@@ -62,11 +77,19 @@ bool Piece::in(Coord coord)
   return false;
 }
 
-void Piece::set_symbol(char symbol) { m_symbol = symbol; }
+void Piece::set_symbol(char symbol)
+{
+  if(symbol != m_symbol) {
+    m_symbol = symbol;
+    changed();
+  }
+}
+
+void Piece::changed() { m_revision++; }
 
 /******************************** DYNAMIC PIECE ********************************/
 
-DynamicPiece::DynamicPiece(Coord location, list<Coord> shape, char symbol, Momentum start_m)
+DynamicPiece::DynamicPiece(Coord location, Shape shape, char symbol, Momentum start_m)
   :Piece(location, shape, symbol),
   m_momentum {start_m},
   m_home {location}
@@ -78,46 +101,54 @@ void DynamicPiece::up(int n_spaces)
 {
   m_location.y -= n_spaces;
   m_momentum = Momentum::up;
+  moved();
 }
 
 void DynamicPiece::down(int n_spaces)
 {
   m_location.y += n_spaces;
   m_momentum = Momentum::down;
+  moved();
 }
 
 void DynamicPiece::left(int n_spaces)
 {
   m_location.x -= n_spaces;
   m_momentum = Momentum::left;
+  moved();
 }
 
 void DynamicPiece::right(int n_spaces)
 {
   m_location.x += n_spaces;
   m_momentum = Momentum::right;
+  moved();
 }
 
 void DynamicPiece::jump(Coord coord) 
 {
   m_location = coord;
+  moved();
 }
 
 void DynamicPiece::jump_home()
 {
   m_location = m_home;
+  moved();
 }
 
 void DynamicPiece::jump(Coord coord, Momentum new_m)
 {
   m_location = coord;
   m_momentum = new_m;
+  moved();
 }
 
 void DynamicPiece::jump_home(Momentum new_m)
 {
   m_location = m_home;
   m_momentum = new_m;
+  moved();
 }
 
 bool DynamicPiece::is_home()
@@ -125,14 +156,57 @@ bool DynamicPiece::is_home()
   return m_location == m_home;
 }
 
+Coord DynamicPiece::home() const { return m_home; }
+
+void DynamicPiece::set_home(Coord home) { m_home = home; }
+
+DynamicPiece::DynamicPiece(DynamicPiece&& other) noexcept
+  :
+  Piece      {std::move(other)},
+  m_momentum {other.m_momentum},
+  m_home     {other.m_home},
+  m_index    {other.m_index},
+  m_slot     {other.m_slot}
+{
+  other.m_index = nullptr;    //the moved from piece no longer updates the slot
+  other.m_slot = -1;
+}
+
+DynamicPiece& DynamicPiece::operator=(DynamicPiece&& other) noexcept
+{
+  Piece::operator=(std::move(other));
+  m_momentum = other.m_momentum;
+  m_home = other.m_home;
+  m_index = other.m_index;
+  m_slot = other.m_slot;
+
+  other.m_index = nullptr;
+  other.m_slot = -1;
+  return *this;
+}
+
+void DynamicPiece::track(PieceIndex* index)
+{
+  m_index = index;
+  m_slot = index ? index->add(m_location) : -1;
+}
+
+void DynamicPiece::moved()
+{
+  if(m_index)
+    m_index->moved(m_slot, m_location);
+}
+
 /**************************** PACMAN ************************************/
 
-PacMan::PacMan()
-  :DynamicPiece(Locations::PACMAN_START, Shapes::POINT, Symbols::PACMAN, Momentum::left),
+PacMan::PacMan(const Level& level)
+  :DynamicPiece(level.locations().pacman_start, Shapes::POINT, Symbols::PACMAN, Momentum::left),
   m_lives {GameConfig::PACMAN_START_LIVES},
   m_points {GameConfig::PACMAN_START_POINTS}
 {}
 
+void PacMan::load(const Level& level) { set_home(level.locations().pacman_start); }
+
 int PacMan::points() const { return m_points; }
 
 void PacMan::inc_points(int inc)
@@ -180,14 +254,20 @@ void PacMan::reset()
 
 /********************************** GHOST ***********************************/
 
-Ghost::Ghost(Coord location, char chase_symbol, char fright_symbol, Coord scatter_target)
-  : DynamicPiece(location, Shapes::POINT, chase_symbol, Momentum::still), 
-  m_chase_symbol {chase_symbol},
-  m_fright_symbol {fright_symbol}
+Ghost::Ghost(const LevelGhost& ghost)
+  : DynamicPiece(ghost.start, Shapes::POINT, GHOST_LOOKS[static_cast<int>(ghost.kind)].chase, Momentum::still),
+  m_kind {ghost.kind},
+  m_scatter_target {ghost.scatter},
+  m_chase_symbol {GHOST_LOOKS[static_cast<int>(ghost.kind)].chase},
+  m_fright_symbol {GHOST_LOOKS[static_cast<int>(ghost.kind)].frightened}
 {}
 
+GhostKind Ghost::kind() const { return m_kind; }
+
 GhostState Ghost::state() const { return m_ghost_state; }
 
+Coord Ghost::scatter_target() const { return m_scatter_target; }
+
 void Ghost::set_state(GhostState new_state)
 {
   m_ghost_state = new_state;
@@ -219,10 +299,15 @@ bool Ghost::eats(PacMan* p)
   return false;
 }
 
-bool Ghost::check_eaten(PacMan* p)
+bool Ghost::edible() const
 {
   //can only be eaten in frightened and turn_around states
-  if(m_ghost_state == GhostState::frightened || m_ghost_state == GhostState::turn_around) {
+  return m_ghost_state == GhostState::frightened || m_ghost_state == GhostState::turn_around;
+}
+
+bool Ghost::check_eaten(PacMan* p)
+{
+  if(edible()) {
     if( in(p) ) {
       m_eaten_flag = EatenFlag::eaten;
       return true;
@@ -249,6 +334,19 @@ void Ghost::reset()
   m_eaten_flag = EatenFlag::not_eaten;
 }
 
+void Ghost::load(const LevelGhost& ghost)
+{
+  set_home(ghost.start);
+  m_scatter_target = ghost.scatter;
+
+  if(ghost.kind != m_kind) {
+    m_kind = ghost.kind;
+    m_chase_symbol = GHOST_LOOKS[static_cast<int>(m_kind)].chase;
+    m_fright_symbol = GHOST_LOOKS[static_cast<int>(m_kind)].frightened;
+    update_symbol();
+  }
+}
+
 void Ghost::update_symbol()
 {
   switch(m_ghost_state)
@@ -270,73 +368,99 @@ void Ghost::update_symbol()
   }
 }
 
-/************************ PINKY, BLINKY, INKY AND CLYDE ************************/
+/******************************** GRIDPIECE ********************************/
 
-Pinky::Pinky()
-  : Ghost(Locations::PINKY_START, 
-          Symbols::PINKY,
-          Symbols::PINKY_FRIGHTENED,
-          Locations::PINKY_SCATTER) 
+GridPiece::GridPiece(TileGrid grid, std::uint8_t flag, char symbol)
+  : Piece(Locations::TOP_LEFT, Shapes::NONE, symbol),
+  m_grid {grid},
+  m_flag {flag}
 {}
 
-Blinky::Blinky()
-  : Ghost(Locations::BLINKY_START,
-          Symbols::BLINKY, 
-          Symbols::BLINKY_FRIGHTENED,
-          Locations::BLINKY_SCATTER) 
-{}
+void GridPiece::draw(Canvas& canvas)
+{
+  Rect area = canvas.area();
+  area.origin = area.origin - m_location;     //the canvas area in grid coords
+  m_grid.for_each(m_flag, area, [&](Coord coord) {
+    Coord location = coord + m_location;
+    canvas.put(location, symbol());
+  });
+}
 
-Clyde::Clyde()
-  : Ghost(Locations::CLYDE_START,
-          Symbols::CLYDE, 
-          Symbols::CLYDE_FRIGHTENED,
-          Locations::CLYDE_SCATTER) 
-{}
+bool GridPiece::in(Coord coord)
+{
+  return m_grid.at(coord - m_location) & m_flag;
+}
 
-Inky::Inky()
-  : Ghost(Locations::INKY_START,
-          Symbols::INKY,
-          Symbols::INKY_FRIGHTENED,
-          Locations::INKY_SCATTER) 
-{}
+void GridPiece::set_grid(TileGrid grid)
+{
+  m_grid = grid;
+  changed();
+}
 
 /***************************** BORDERS and INVWALLS *****************************/
 
-Borders::Borders()
-  : Piece(Locations::TOP_LEFT, Shapes::BORDER, Symbols::BORDER) {}
+Borders::Borders(const Level& level)
+  : GridPiece(level.grid(), Tile::BORDER, Symbols::BORDER) {}
+
+void Borders::load(const Level& level) { set_grid(level.grid()); }
 
-InvWalls::InvWalls()
-  :Piece(Locations::TOP_LEFT, Shapes::INV_WALLS, Symbols::INVISIBLE) {}
+InvWalls::InvWalls(const Level& level)
+  : GridPiece(level.grid(), Tile::INV_WALL, Symbols::INVISIBLE) {}
+
+void InvWalls::load(const Level& level) { set_grid(level.grid()); }
 
 /************************** WARP, LEFTWARP, RIGHTWARP ***************************/
 Warp::Warp(Coord location)
   :Piece(location, Shapes::POINT, Symbols::INVISIBLE) {}
 
-LeftWarp::LeftWarp()
-  :Warp(Locations::LEFT_WARP) {}
+LeftWarp::LeftWarp(const Level& level)
+  :Warp(level.locations().left_warp) {}
+
+void LeftWarp::load(const Level& level) { m_location = level.locations().left_warp; }
 
-RightWarp::RightWarp()
-  :Warp(Locations::RIGHT_WARP) {}
+RightWarp::RightWarp(const Level& level)
+  :Warp(level.locations().right_warp) {}
+
+void RightWarp::load(const Level& level) { m_location = level.locations().right_warp; }
 
 /********************************** SCORINGPIECE ***********************************/
 
-ScoringPiece::ScoringPiece(Coord location, list<Coord> shape, char symbol, int value)
-  : Piece(location, shape, symbol), 
-  m_original_shape {shape},
+ScoringPiece::ScoringPiece(Coord location, TileBitsetView cells, int n_cells, char symbol, int value)
+  : Piece(location, Shapes::NONE, symbol),
+  m_original_cells {cells},
+  m_cells {cells},
+  m_original_count {n_cells},
+  m_remaining {n_cells},
   m_value{value}
 {}
 
 int ScoringPiece::value() { return m_value; }
 
+void ScoringPiece::draw(Canvas& canvas)
+{
+  Rect area = canvas.area();
+  area.origin = area.origin - m_location;
+  m_cells.for_each(area, [&](Coord coord) {
+    Coord location = coord + m_location;
+    canvas.put(location, symbol());
+  });
+}
+
+bool ScoringPiece::in(Coord coord)
+{
+  return m_cells.test(coord - m_location);
+}
+
 bool ScoringPiece::check_score(Piece* p)
 {
-  for(Coord p_c: p->shape()) {   //nested for loops, so we can compare all the coords against each other
-    for(Coord c : m_shape) {
-      if( (c + m_location) == (p_c + p->location())) {   //if we get a score
-        m_shape.remove(c);                               //remove scoring coord
-        m_score_flag = ScoreFlag::score;                 //set score flag
-        return true;                                     //return true
-      }
+  for(Coord p_c: p->shape()) {
+    Coord c = (p_c + p->location()) - m_location;   //p's coord relative to our location
+    if(m_cells.test(c)) {                           //if we get a score
+      m_cells.clear(c);                             //clear scoring coord
+      m_remaining--;
+      changed();
+      m_score_flag = ScoreFlag::score;              //set score flag
+      return true;                                  //return true
     }
   }
   m_score_flag = ScoreFlag::no_score;
@@ -348,9 +472,13 @@ bool ScoringPiece::score()
   return m_score_flag == ScoreFlag::score;
 }
 
+int ScoringPiece::remaining() const { return m_remaining; }
+
 void ScoringPiece::reset()
 {
-  m_shape = m_original_shape;
+  m_cells.copy_from(m_original_cells);
+  m_remaining = m_original_count;
+  changed();
   m_score_flag = ScoreFlag::no_score;
 }
 
@@ -358,22 +486,37 @@ void ScoringPiece::reset_score_flag()
 {
   m_score_flag = ScoreFlag::no_score;
 }
+
+void ScoringPiece::set_cells(TileBitsetView cells, int n_cells)
+{
+  m_original_cells = cells;
+  m_original_count = n_cells;
+  m_cells = TileBitset{cells};
+  m_remaining = n_cells;
+  changed();
+  m_score_flag = ScoreFlag::no_score;
+}
+
 /******************************  POINTS *********************************/
 
-Points::Points()
-  :ScoringPiece(Locations::TOP_LEFT, Shapes::POINTS, Symbols::POINTS, GameConfig::POINT_VALUE) {}
+Points::Points(const Level& level)
+  :ScoringPiece(Locations::TOP_LEFT, level.points(), level.point_count(), Symbols::POINTS, GameConfig::POINT_VALUE) {}
+
+void Points::load(const Level& level) { set_cells(level.points(), level.point_count()); }
 
 bool Points::all_eaten()
 {
-  return m_shape.empty();
+  return remaining() == 0;
 }
 
 /*********************************** POWERUPS ***********************************/
 
-PowerUps::PowerUps()
-  :ScoringPiece(Locations::TOP_LEFT, Shapes::POWER_UPS, Symbols::POWER_UPS, GameConfig::POWER_UP_VALUE) {}
+PowerUps::PowerUps(const Level& level)
+  :ScoringPiece(Locations::TOP_LEFT, level.power_ups(), level.power_up_count(), Symbols::POWER_UPS, GameConfig::POWER_UP_VALUE) {}
+
+void PowerUps::load(const Level& level) { set_cells(level.power_ups(), level.power_up_count()); }
 
-PowerUpState PowerUps::state() { return m_power_up_state; }
+PowerUpState PowerUps::state() const { return m_power_up_state; }
 
 void PowerUps::set_state(PowerUpState new_state) { m_power_up_state = new_state; }
 
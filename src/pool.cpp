@@ -0,0 +1,136 @@
+#include "pool.h"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+
+WorkPool::WorkPool(int threads)
+{
+  threads = std::max(threads, 1);
+
+  for(int i = 0; i < threads; i++) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  for(int i = 0; i < threads; i++) {
+    m_threads.emplace_back(&WorkPool::work, this, i);
+  }
+}
+
+WorkPool::~WorkPool()
+{
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    m_stop = true;
+  }
+  m_start.notify_all();
+
+  for(std::thread& thread : m_threads) {
+    thread.join();
+  }
+}
+
+int WorkPool::threads() const { return m_threads.size(); }
+
+long WorkPool::steals() const { return m_steals; }
+
+void WorkPool::run(long count, const std::function<void(long, int)>& task)
+{
+  int workers = threads();
+
+  //give each worker a contiguous run of indices
+  for(int worker = 0; worker < workers; worker++) {
+    Queue& queue = *m_queues[worker];
+    std::lock_guard<std::mutex> lock {queue.mutex};
+    for(long index = count * worker / workers; index < count * (worker + 1) / workers; index++) {
+      queue.tasks.push_back(index);
+    }
+  }
+
+  std::unique_lock<std::mutex> lock {m_mutex};
+  m_task = &task;
+  m_error = nullptr;
+  m_busy = workers;
+  m_batch++;
+  m_start.notify_all();
+
+  m_done.wait(lock, [&] { return m_busy == 0; });
+  m_task = nullptr;
+
+  if(m_error)
+    std::rethrow_exception(m_error);
+}
+
+void WorkPool::work(int worker)
+{
+  long batch {0};
+
+  while(true) {
+    const std::function<void(long, int)>* task;
+    {
+      std::unique_lock<std::mutex> lock {m_mutex};
+      m_start.wait(lock, [&] { return m_stop || m_batch != batch; });
+      if(m_stop)
+        return;
+      batch = m_batch;
+      task = m_task;
+    }
+
+    long index;
+    bool stolen;
+    long steals {0};
+    std::exception_ptr error;
+
+    while(next_task(worker, index, stolen)) {
+      steals += stolen;
+      try {
+        (*task)(index, worker);
+      } catch(...) {
+        if(!error)
+          error = std::current_exception();
+      }
+    }
+
+    //no tasks are added during a batch, so once every queue is empty this worker is done
+    std::lock_guard<std::mutex> lock {m_mutex};
+    m_steals += steals;
+    if(error && !m_error)
+      m_error = error;
+    if(--m_busy == 0)
+      m_done.notify_one();
+  }
+}
+
+bool WorkPool::next_task(int worker, long& index, bool& stolen)
+{
+  {
+    Queue& own = *m_queues[worker];
+    std::lock_guard<std::mutex> lock {own.mutex};
+    if(!own.tasks.empty()) {
+      index = own.tasks.front();
+      own.tasks.pop_front();
+      stolen = false;
+      return true;
+    }
+  }
+
+  //steal from the back of the other queues, starting with the next worker along
+  int workers = m_queues.size();
+  for(int i = 1; i < workers; i++) {
+    Queue& victim = *m_queues[(worker + i) % workers];
+    std::lock_guard<std::mutex> lock {victim.mutex};
+    if(!victim.tasks.empty()) {
+      index = victim.tasks.back();
+      victim.tasks.pop_back();
+      stolen = true;
+      return true;
+    }
+  }
+
+  return false;
+}
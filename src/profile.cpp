@@ -0,0 +1,196 @@
+#include "profile.h"
+
+#ifdef PACMAN_PROFILE
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+
+using std::int64_t;
+using std::size_t;
+
+namespace
+{
+  constexpr const char* PHASE_NAMES[PROFILE_PHASES] {"input", "pacman", "ghosts", "score", "draw", "resets", "end", "wait"};
+
+  constexpr std::chrono::milliseconds WRITER_SLEEP {1};    //how long the writer waits when the ring is empty
+}
+
+const char* phase_name(ProfilePhase phase) { return PHASE_NAMES[static_cast<int>(phase)]; }
+
+/********************************* SAMPLERING **********************************/
+
+SampleRing::SampleRing(size_t size)
+  : m_slots(size), m_mask {size - 1} {}
+
+bool SampleRing::push(const ProfileSample& sample)
+{
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  if(tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+    return false;
+
+  m_slots[tail & m_mask] = sample;
+  m_tail.store(tail + 1, std::memory_order_release);   //publish the slot to the consumer
+  return true;
+}
+
+bool SampleRing::pop(ProfileSample& sample)
+{
+  size_t head = m_head.load(std::memory_order_relaxed);
+  if(head == m_tail.load(std::memory_order_acquire))
+    return false;
+
+  sample = m_slots[head & m_mask];
+  m_head.store(head + 1, std::memory_order_release);   //give the slot back to the producer
+  return true;
+}
+
+/********************************** PROFILER ***********************************/
+
+Profiler::Profiler()
+  : m_epoch {Clock::now()}, m_ring {PROFILE_RING_SIZE} {}
+
+Profiler::~Profiler()
+{
+  if(m_writer.joinable()) {
+    m_stop = true;
+    m_writer.join();
+  }
+
+  if(m_csv)
+    std::fclose(m_csv);
+  if(m_trace)
+    std::fclose(m_trace);
+}
+
+void Profiler::export_to(const std::string& csv_file, const std::string& trace_file)
+{
+  if(!csv_file.empty() && !(m_csv = std::fopen(csv_file.c_str(), "w")))
+    throw ProfileError{"can't open '" + csv_file + "' for writing"};
+  if(!trace_file.empty() && !(m_trace = std::fopen(trace_file.c_str(), "w")))
+    throw ProfileError{"can't open '" + trace_file + "' for writing"};
+
+  if(m_csv || m_trace)
+    m_writer = std::thread {&Profiler::write, this};
+}
+
+void Profiler::begin_tick(long tick)
+{
+  m_tick = tick;
+
+  for(int phase = 0; phase < PROFILE_PHASES; phase++) {
+    m_window[phase][tick % PROFILE_WINDOW] = 0;
+  }
+  m_window_ticks = std::min<long>(m_window_ticks + 1, PROFILE_WINDOW);
+}
+
+void Profiler::record(ProfilePhase phase, Clock::time_point start, Clock::time_point end)
+{
+  int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+  //a phase can run more than once a tick, like draw, so its time adds up
+  m_window[static_cast<int>(phase)][m_tick % PROFILE_WINDOW] += duration;
+
+  if(m_writer.joinable()) {
+    int64_t since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_epoch).count();
+    if(!m_ring.push(ProfileSample{m_tick, phase, since_epoch, duration}))
+      m_dropped++;
+  }
+}
+
+int64_t Profiler::percentile_ns(ProfilePhase phase, int p) const
+{
+  if(m_window_ticks == 0)
+    return 0;
+
+  int64_t values[PROFILE_WINDOW];
+  const int64_t* window = m_window[static_cast<int>(phase)];
+
+  //the window fills from slot 0, so before it wraps the filled slots are the first ones
+  std::copy(window, window + m_window_ticks, values);
+
+  int64_t* nth = values + (m_window_ticks - 1) * p / 100;
+  std::nth_element(values, nth, values + m_window_ticks);
+  return *nth;
+}
+
+long Profiler::dropped() const { return m_dropped; }
+
+/*********************************** WRITER ************************************/
+
+void Profiler::write()
+{
+  if(m_csv) {
+    std::fprintf(m_csv, "tick");
+    for(const char* name : PHASE_NAMES) {
+      std::fprintf(m_csv, ",%s_us", name);
+    }
+    std::fprintf(m_csv, "\n");
+  }
+  if(m_trace)
+    std::fprintf(m_trace, "{\"traceEvents\":[\n");
+
+  long row_tick {-1};
+  int64_t row[PROFILE_PHASES] {};
+  bool first {true};
+
+  ProfileSample sample;
+  bool stopping {false};
+
+  //drain until the ring is empty after a stop was asked for
+  while(true) {
+    if(!m_ring.pop(sample)) {
+      if(stopping)
+        break;
+      stopping = m_stop;
+      if(!stopping)
+        std::this_thread::sleep_for(WRITER_SLEEP);
+      continue;
+    }
+
+    if(m_csv) {
+      if(sample.tick != row_tick) {
+        if(row_tick >= 0)
+          write_csv_row(row_tick, row);
+        row_tick = sample.tick;
+        std::fill(row, row + PROFILE_PHASES, 0);
+      }
+      row[static_cast<int>(sample.phase)] += sample.duration_ns;
+    }
+
+    if(m_trace) {
+      write_trace_event(sample, first);
+      first = false;
+    }
+  }
+
+  if(m_csv && row_tick >= 0)
+    write_csv_row(row_tick, row);
+  if(m_trace)
+    std::fprintf(m_trace, "\n]}\n");
+}
+
+void Profiler::write_csv_row(long tick, const int64_t* durations)
+{
+  std::fprintf(m_csv, "%ld", tick);
+  for(int phase = 0; phase < PROFILE_PHASES; phase++) {
+    std::fprintf(m_csv, ",%.3f", durations[phase] / 1000.0);
+  }
+  std::fprintf(m_csv, "\n");
+}
+
+void Profiler::write_trace_event(const ProfileSample& sample, bool first)
+{
+  //a complete event, times in microseconds
+  std::fprintf(m_trace, "%s{\"name\":\"%s\",\"cat\":\"tick\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                        "\"pid\":1,\"tid\":1,\"args\":{\"tick\":%ld}}",
+               first ? "" : ",\n", phase_name(sample.phase),
+               sample.start_ns / 1000.0, sample.duration_ns / 1000.0, sample.tick);
+}
+
+#endif
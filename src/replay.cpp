@@ -0,0 +1,279 @@
+#include "replay.h"
+#include "backend.h"
+#include "game.h"
+#include "config.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using std::string;
+using std::vector;
+using std::uint8_t;
+using std::uint32_t;
+using std::uint64_t;
+
+namespace
+{
+  /******************** little endian fields and varints ********************/
+
+  void put_u32(string& out, uint32_t value)
+  {
+    for(int i = 0; i < 4; i++) {
+      out.push_back(static_cast<char>(value >> (i * 8)));
+    }
+  }
+
+  void put_u64(string& out, uint64_t value)
+  {
+    for(int i = 0; i < 8; i++) {
+      out.push_back(static_cast<char>(value >> (i * 8)));
+    }
+  }
+
+  void put_varint(string& out, uint64_t value)
+  {
+    while(value >= 0x80) {
+      out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+  }
+
+  //reads fields back out of a replay file, throwing if it runs out
+  class Reader
+  {
+    public:
+      explicit Reader(const string& data) : m_data {data} {}
+
+      uint64_t fixed(int n_bytes)
+      {
+        need(n_bytes);
+        uint64_t value {0};
+        for(int i = 0; i < n_bytes; i++) {
+          value |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_pos++])) << (i * 8);
+        }
+        return value;
+      }
+
+      uint64_t varint()
+      {
+        uint64_t value {0};
+        for(int shift = 0; shift < 64; shift += 7) {
+          need(1);
+          uint8_t byte = m_data[m_pos++];
+          value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+          if(!(byte & 0x80))
+            return value;
+        }
+        throw ReplayError{"replay has a bad varint"};
+      }
+
+      void bytes(char* out, std::size_t n)
+      {
+        need(n);
+        std::memcpy(out, m_data.data() + m_pos, n);
+        m_pos += n;
+      }
+
+      std::size_t remaining() const { return m_data.size() - m_pos; }
+
+    private:
+      const string& m_data;
+      std::size_t m_pos {0};
+
+      void need(std::size_t n)
+      {
+        if(m_pos + n > m_data.size())
+          throw ReplayError{"replay is truncated"};
+      }
+  };
+}
+
+/*********************************** REPLAY ***********************************/
+
+Replay::Replay(uint64_t seed, uint64_t level_checksum)
+  :
+  m_seed {seed},
+  m_level_checksum {level_checksum}
+{}
+
+Replay Replay::load(const string& file)
+{
+  std::ifstream ist {file, std::ios::binary};
+  if(!ist)
+    throw ReplayError{"could not open replay '" + file + "'"};
+
+  std::ostringstream contents;
+  contents << ist.rdbuf();
+  const string data = contents.str();
+
+  Reader reader {data};
+
+  char magic[8];
+  reader.bytes(magic, sizeof(magic));
+  if(std::memcmp(magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0)
+    throw ReplayError{"'" + file + "' is not a replay"};
+
+  uint32_t version = reader.fixed(4);
+  if(version != REPLAY_VERSION)
+    throw ReplayError{"'" + file + "' is replay version " + std::to_string(version)
+                      + ", expected version " + std::to_string(REPLAY_VERSION)};
+
+  uint64_t seed = reader.fixed(8);
+  uint64_t level_checksum = reader.fixed(8);
+  uint64_t ticks = reader.fixed(8);
+
+  //every tick has a 4 byte hash, so a tick count the file cant hold is a lie, not something to reserve
+  if(ticks > reader.remaining() / 4)
+    throw ReplayError{"'" + file + "' is truncated or has a bad tick count"};
+
+  Replay replay {seed, level_checksum};
+  replay.m_inputs.reserve(ticks);
+  replay.m_hashes.reserve(ticks);
+
+  //expand the input runs
+  while(replay.m_inputs.size() < ticks) {
+    int input = static_cast<int>(reader.varint()) - 1;
+    uint64_t length = reader.varint();
+    if(length == 0 || length > ticks - replay.m_inputs.size())
+      throw ReplayError{"'" + file + "' has a bad input run"};
+    replay.m_inputs.insert(replay.m_inputs.end(), length, input);
+  }
+
+  for(uint64_t i = 0; i < ticks; i++) {
+    replay.m_hashes.push_back(reader.fixed(4));
+  }
+
+  return replay;
+}
+
+void Replay::save(const string& file) const
+{
+  string out;
+  out.append(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+  put_u32(out, REPLAY_VERSION);
+  put_u64(out, m_seed);
+  put_u64(out, m_level_checksum);
+  put_u64(out, m_inputs.size());
+
+  //run length encode the inputs, +1 so ERR (-1) from ncurses encodes as 0
+  for(std::size_t i = 0; i < m_inputs.size(); ) {
+    std::size_t run = 1;
+    while(i + run < m_inputs.size() && m_inputs[i + run] == m_inputs[i])
+      run++;
+    put_varint(out, static_cast<uint64_t>(m_inputs[i] + 1));
+    put_varint(out, run);
+    i += run;
+  }
+
+  for(uint32_t hash : m_hashes) {
+    put_u32(out, hash);
+  }
+
+  std::ofstream ost {file, std::ios::binary | std::ios::trunc};
+  ost.write(out.data(), out.size());
+  ost.close();
+  if(!ost)
+    throw ReplayError{"could not write replay '" + file + "'"};
+}
+
+uint64_t Replay::seed() const { return m_seed; }
+
+uint64_t Replay::level_checksum() const { return m_level_checksum; }
+
+long Replay::ticks() const { return m_inputs.size(); }
+
+int Replay::input(long tick) const { return m_inputs[tick]; }
+
+uint32_t Replay::hash(long tick) const { return m_hashes[tick]; }
+
+void Replay::add(int input, uint32_t hash)
+{
+  m_inputs.push_back(input);
+  m_hashes.push_back(hash);
+}
+
+/****************************** RECORDINGBACKEND *******************************/
+
+RecordingBackend::RecordingBackend(Backend& backend, Replay& replay)
+  :
+  m_backend {backend},
+  m_replay {replay}
+{}
+
+void RecordingBackend::attach(GameCore& core) { m_backend.attach(core); }
+
+int RecordingBackend::get_input(InputMode input_mode)
+{
+  int input = m_backend.get_input(input_mode);
+  if(input_mode == InputMode::non_block)
+    m_tick_input = input;     //only tick input is recorded, not the prompts
+  return input;
+}
+
+void RecordingBackend::draw_frame(const Game& game) { m_backend.draw_frame(game); }
+
+void RecordingBackend::show_message(const string& text) { m_backend.show_message(text); }
+
+void RecordingBackend::pause(int n_milliseconds) { m_backend.pause(n_milliseconds); }
+
+void RecordingBackend::end_tick(const Game& game)
+{
+  m_replay.add(m_tick_input, game.core().state_hash());
+  m_backend.end_tick(game);
+}
+
+/******************************* REPLAYBACKEND ********************************/
+
+ReplayBackend::ReplayBackend(Backend& backend, const Replay& replay)
+  :
+  m_backend {backend},
+  m_replay {replay}
+{}
+
+void ReplayBackend::attach(GameCore& core) { m_backend.attach(core); }
+
+int ReplayBackend::get_input(InputMode input_mode)
+{
+  if(input_mode == InputMode::block)    //start and play again prompts
+    return finished() ? Inputs::QUIT : Inputs::PLAY;
+
+  if(m_backend.get_input(InputMode::non_block) == Inputs::QUIT || finished())
+    return Inputs::QUIT;
+
+  return m_replay.input(m_tick);
+}
+
+void ReplayBackend::draw_frame(const Game& game) { m_backend.draw_frame(game); }
+
+void ReplayBackend::show_message(const string& text) { m_backend.show_message(text); }
+
+void ReplayBackend::pause(int n_milliseconds) { m_backend.pause(n_milliseconds); }
+
+void ReplayBackend::end_tick(const Game& game)
+{
+  uint32_t hash = game.core().state_hash();
+  if(hash != m_replay.hash(m_tick)) {
+    m_diverged_tick = m_tick;
+    m_diverged_hash = hash;
+  }
+  m_tick++;
+  m_backend.end_tick(game);
+}
+
+long ReplayBackend::ticks_checked() const { return m_tick; }
+
+bool ReplayBackend::diverged() const { return m_diverged_tick >= 0; }
+
+long ReplayBackend::diverged_tick() const { return m_diverged_tick; }
+
+uint32_t ReplayBackend::diverged_hash() const { return m_diverged_hash; }
+
+bool ReplayBackend::finished() const
+{
+  return diverged() || m_tick >= m_replay.ticks();
+}
@@ -0,0 +1,55 @@
+#include "rng.h"
+
+#include <cstdint>
+
+using std::uint64_t;
+
+namespace
+{
+  //splitmix64, used to spread a single seed over the whole xoshiro state
+  uint64_t splitmix64(uint64_t& x)
+  {
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t rotl(uint64_t x, int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+}
+
+Rng::Rng(uint64_t seed)
+  : m_seed {seed}
+{
+  uint64_t x = seed;
+  for(uint64_t& s : m_state) {
+    s = splitmix64(x);
+  }
+}
+
+uint64_t Rng::seed() const { return m_seed; }
+
+uint64_t Rng::next()
+{
+  const uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+  const uint64_t t = m_state[1] << 17;
+
+  m_state[2] ^= m_state[0];
+  m_state[3] ^= m_state[1];
+  m_state[1] ^= m_state[2];
+  m_state[0] ^= m_state[3];
+
+  m_state[2] ^= t;
+  m_state[3] = rotl(m_state[3], 45);
+
+  return result;
+}
+
+int Rng::below(int n)
+{
+  //scale the top 32 bits into [0, n), no division and no modulo bias worth caring about
+  return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32);
+}
@@ -2,19 +2,87 @@
 #include "pieces.h"
 #include "coord.h"
 #include "config.h"
+#include "canvas.h"
+#include "core.h"
+#include "game.h"
+#include "profile.h"
+#include "metrics.h"
 
 #include <ncurses.h>
 #include <vector>
+#include <algorithm>
 #include <string>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
 
 using std::vector;
 using std::string;
+using std::to_string;
+
+namespace
+{
+  constexpr int CHUNK_H {16};     //rows of the maze in a background chunk
+  constexpr int CHUNK_W {64};     //columns
+
+  //a canvas that draws onto an ncurses window, showing the maze from camera on
+  class WindowCanvas : public Canvas
+  {
+    public:
+      WindowCanvas(WINDOW* window, Coord camera, int height, int length)
+        : m_window {window}, m_area {camera, length, height} {}
+
+      void put(Coord coord, char symbol) override
+      {
+        if(contains(m_area, coord))
+          mvwaddch(m_window, coord.y - m_area.origin.y, coord.x - m_area.origin.x, symbol);
+      }
+
+      Rect area() const override { return m_area; }
+
+    private:
+      WINDOW* m_window;
+      Rect m_area;
+  };
+
+  //a canvas that draws into a background chunks cells
+  class ChunkCanvas : public Canvas
+  {
+    public:
+      ChunkCanvas(char* cells, Coord origin)
+        : m_cells {cells}, m_area {origin, CHUNK_W, CHUNK_H} {}
+
+      void put(Coord coord, char symbol) override
+      {
+        if(contains(m_area, coord))
+          m_cells[(coord.y - m_area.origin.y) * CHUNK_W + coord.x - m_area.origin.x] = symbol;
+      }
+
+      Rect area() const override { return m_area; }
+
+    private:
+      char* m_cells;
+      Rect m_area;
+  };
+}
 
 /************************************ Screen ************************************/
 
-Screen::Screen()
+Screen::Screen(Histogram* write_sizes)
+  : m_write_sizes {write_sizes}
 {
-  initscr();              //start ncurses stdscrn
+  if(m_write_sizes)
+    start_relay();        //start ncurses on the pipe
+  else
+    initscr();            //start ncurses stdscrn
   cbreak();               //dont buffer input (so we dont need to press ENTER to get inpt)
   noecho();               //dont print keypresses to screen
   keypad(stdscr, TRUE);   //let ncurses read function keys
@@ -25,6 +93,82 @@ Screen::Screen()
 Screen::~Screen()
 {
   endwin();    //end stdscrn
+
+  if(m_screen) {
+    delscreen(m_screen);
+    std::fclose(m_output);      //the relay sees the end of the pipe and stops
+    m_relay.join();
+    close(m_relay_fd);
+  }
+
+  if(m_modes_saved)
+    tcsetattr(STDIN_FILENO, TCSANOW, &m_saved_modes);
+}
+
+void Screen::start_relay()
+{
+  //the modes cbreak() and noecho() would set, since ncurses can only set them through its output
+  if(tcgetattr(STDIN_FILENO, &m_saved_modes) == 0) {
+    m_modes_saved = true;
+
+    termios modes = m_saved_modes;
+    modes.c_lflag &= ~(ICANON | ECHO);
+    modes.c_lflag |= ISIG;
+    modes.c_iflag &= ~ICRNL;
+    modes.c_cc[VMIN] = 1;
+    modes.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &modes);
+  }
+
+  fit_terminal();
+
+  int fds[2];
+  if(pipe2(fds, O_CLOEXEC) != 0)
+    throw std::runtime_error{"can't create the terminal output pipe"};
+
+  m_relay_fd = fds[0];
+  m_output = fdopen(fds[1], "w");
+  m_relay = std::thread {&Screen::relay, this};
+
+  m_screen = newterm(nullptr, m_output, stdin);
+  set_term(m_screen);
+}
+
+void Screen::fit_terminal()
+{
+  winsize size;
+  if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row == 0 || size.ws_col == 0)
+    return;
+
+  //ncurses cant ask a pipe for the terminal size, it looks in the environment instead,
+  //on start and on every SIGWINCH, so keep the environment up to date too
+  setenv("LINES", to_string(size.ws_row).c_str(), 1);
+  setenv("COLUMNS", to_string(size.ws_col).c_str(), 1);
+
+  if(m_screen)
+    resizeterm(size.ws_row, size.ws_col);
+}
+
+void Screen::relay()
+{
+  char buffer[1 << 16];
+  bool terminal_open {true};
+  ssize_t n;
+
+  while((n = read(m_relay_fd, buffer, sizeof(buffer))) > 0) {
+    m_relayed.fetch_add(n, std::memory_order_relaxed);
+
+    //once the terminal is gone keep emptying the pipe, so ncurses never blocks on it
+    for(ssize_t written = 0; terminal_open && written < n; ) {
+      ssize_t w = write(STDOUT_FILENO, buffer + written, n - written);
+      if(w < 0 && errno == EINTR)
+        continue;
+      if(w <= 0)
+        terminal_open = false;
+      else
+        written += w;
+    }
+  }
 }
 
 int Screen::get_ch(InputMode input_mode)
@@ -35,9 +179,24 @@ int Screen::get_ch(InputMode input_mode)
   input = getch();                                      //get our input
   nodelay(stdscr,FALSE);                                //go back to blocking as default
 
+  if(input == KEY_RESIZE && m_screen)
+    fit_terminal();                                     //ncurses only saw the environment
+
   return input;
 }
 
+void Screen::update()
+{
+  //the last frame, and what ncurses wrote checking for input after it, has been relayed by now
+  if(m_screen) {
+    std::uint64_t relayed = m_relayed.load(std::memory_order_relaxed);
+    m_write_sizes->record(relayed - m_recorded);
+    m_recorded = relayed;
+  }
+
+  doupdate();   //write every window staged with wnoutrefresh in one burst
+}
+
 /************************************ Window ************************************/
 
 Window::Window(int height, int length, Coord stdscr_location)
@@ -57,29 +216,71 @@ Window::~Window()
   }
 }
 
+bool Window::place(int height, int length, Coord stdscr_location)
+{
+  if(height == m_height && length == m_length && stdscr_location == m_stdscr_location)
+    return false;
+
+  m_height = height;
+  m_length = length;
+  m_stdscr_location = stdscr_location;
+
+  wresize(m_window, m_height, m_length);
+  mvwin(m_window, m_stdscr_location.x, m_stdscr_location.y);
+  return true;
+}
+
+void Window::touch() { touchwin(m_window); }
+
 /********************************** GameWindow **********************************/
 
 GameWindow::GameWindow(int height, int length, Coord stdscr_location)
-  : Window(height, length, stdscr_location) {}
+  : Window(height, length, stdscr_location)
+{
+  show_maze(length, height);
+}
 
 void GameWindow::print()
 {
-  //clear the previous print
-  werase(m_window);
+  if(background_changed()) {
+    m_generation++;     //every chunk is out of date, the ones in view get drawn again below
+    for(std::size_t i = 0; i < m_background.size(); i++) {
+      m_background_revisions[i] = m_background[i]->revision();
+    }
+    m_background_stale = false;
+  }
 
-  //draw each piece onto its layer
-  for(Piece* piece : m_background) {
-    piece->draw(m_window);
+  move_camera();
+
+  //blank whatever part of the window the maze doesnt cover
+  Rect view = intersect(Rect{m_camera, m_length, m_height}, Rect{Coord{0, 0}, m_maze_width, m_maze_height});
+  if(view.width < m_length || view.height < m_height)
+    werase(m_window);
+
+  //copy the rows of every chunk in view onto the window
+  for(int row = view.origin.y / CHUNK_H; row * CHUNK_H < view.origin.y + view.height; row++) {
+    for(int col = view.origin.x / CHUNK_W; col * CHUNK_W < view.origin.x + view.width; col++) {
+      const Chunk& drawn = chunk(col, row);
+      Rect cells = intersect(view, Rect{Coord{col * CHUNK_W, row * CHUNK_H}, CHUNK_W, CHUNK_H});
+
+      for(int y = cells.origin.y; y < cells.origin.y + cells.height; y++) {
+        const char* from = &drawn.cells[(y - row * CHUNK_H) * CHUNK_W + cells.origin.x - col * CHUNK_W];
+        mvwaddnstr(m_window, y - m_camera.y, cells.origin.x - m_camera.x, from, cells.width);
+      }
+    }
   }
+
+  //draw the moving pieces on top
+  WindowCanvas canvas {m_window, m_camera, m_height, m_length};
   for(Piece* piece : m_midground) {
-    piece->draw(m_window);
+    piece->draw(canvas);
   }
   for(Piece* piece : m_foreground) {
-    piece->draw(m_window);
+    piece->draw(canvas);
   }
 
-  //print the window onto the stdscrn
-  wrefresh(m_window);
+  //stage the window for the next screen update
+  wnoutrefresh(m_window);
 }
 
 void GameWindow::add(Piece* piece, WindowLayer layer)
@@ -87,6 +288,8 @@ void GameWindow::add(Piece* piece, WindowLayer layer)
   switch(layer) {
     case WindowLayer::background: {
       m_background.push_back(piece);
+      m_background_revisions.push_back(piece->revision());
+      m_background_stale = true;
       break;
     }
     case WindowLayer::midground: {
@@ -99,6 +302,82 @@ void GameWindow::add(Piece* piece, WindowLayer layer)
   }
 }
 
+void GameWindow::clear()
+{
+  m_background.clear();
+  m_background_revisions.clear();
+  m_midground.clear();
+  m_foreground.clear();
+  m_background_stale = true;
+  m_followed = nullptr;
+}
+
+void GameWindow::show_maze(int width, int height)
+{
+  m_maze_width = width;
+  m_maze_height = height;
+
+  //the chunks are drawn as they come into view, so a maze of any size costs nothing here
+  m_chunk_cols = (width + CHUNK_W - 1) / CHUNK_W;
+  int chunk_rows = (height + CHUNK_H - 1) / CHUNK_H;
+  m_chunks.assign(static_cast<std::size_t>(m_chunk_cols) * chunk_rows, Chunk{});
+  m_background_stale = true;
+}
+
+void GameWindow::follow(const Piece* piece) { m_followed = piece; }
+
+Coord GameWindow::camera() const { return m_camera; }
+
+bool GameWindow::background_changed()
+{
+  if(m_background_stale)
+    return true;
+
+  for(std::size_t i = 0; i < m_background.size(); i++) {
+    if(m_background[i]->revision() != m_background_revisions[i])
+      return true;
+  }
+  return false;
+}
+
+void GameWindow::move_camera()
+{
+  if(m_followed) {
+    Coord at = m_followed->location();
+    int margin_x = m_length / 4;
+    int margin_y = m_height / 4;
+
+    if(at.x < m_camera.x + margin_x)
+      m_camera.x = at.x - margin_x;
+    else if(at.x >= m_camera.x + m_length - margin_x)
+      m_camera.x = at.x - m_length + margin_x + 1;
+
+    if(at.y < m_camera.y + margin_y)
+      m_camera.y = at.y - margin_y;
+    else if(at.y >= m_camera.y + m_height - margin_y)
+      m_camera.y = at.y - m_height + margin_y + 1;
+  }
+
+  //stay on the maze, a maze smaller than the window sits at its top left
+  m_camera.x = std::max(0, std::min(m_camera.x, m_maze_width - m_length));
+  m_camera.y = std::max(0, std::min(m_camera.y, m_maze_height - m_height));
+}
+
+const GameWindow::Chunk& GameWindow::chunk(int col, int row)
+{
+  Chunk& chunk = m_chunks[row * m_chunk_cols + col];
+  if(chunk.generation == m_generation)
+    return chunk;
+
+  chunk.cells.assign(CHUNK_H * CHUNK_W, Symbols::INVISIBLE);
+  ChunkCanvas canvas {chunk.cells.data(), Coord{col * CHUNK_W, row * CHUNK_H}};
+  for(Piece* piece : m_background) {
+    piece->draw(canvas);
+  }
+  chunk.generation = m_generation;
+  return chunk;
+}
+
 /********************************** TextWindow **********************************/
 
 TextWindow::TextWindow(int height, int length, Coord stdscr_location)
@@ -108,10 +387,142 @@ void TextWindow::print()
 {
   werase(m_window);                     //clear the previous prints
   waddstr(m_window, m_text.c_str());    //draw text onto window
-  wrefresh(m_window);                   //print the window onto stdscrn
+  wnoutrefresh(m_window);               //stage the window for the next screen update
 }
 
 void TextWindow::update_text(const string& text)
 {
   m_text = text;
 }
+
+/******************************** NcursesBackend ********************************/
+
+NcursesBackend::NcursesBackend(Metrics* metrics)
+  :
+  m_scrn {metrics ? &metrics->terminal_write_bytes : nullptr},
+  m_game_win {Dimensions::GAME_SCR_MIN_H, Dimensions::GAME_SCR_MIN_W, Dimensions::GAME_SCR_COORD},
+  m_stat_win {Dimensions::STAT_SCR_H, Dimensions::STAT_SCR_W,
+              Coord{Dimensions::GAME_SCR_COORD.x + Dimensions::GAME_SCR_MIN_H, Dimensions::GAME_SCR_COORD.y}},
+  m_message_win {Dimensions::MSG_SCR_H, Dimensions::GAME_SCR_MIN_W, Dimensions::MSG_SCR_COORD}
+{}
+
+void NcursesBackend::attach(GameCore& core)
+{
+  m_game_win.clear();     //attaching again after a maze swap replaces the old pieces
+
+  m_maze_width = core.maze_width();
+  m_maze_height = core.maze_height();
+  layout();
+  m_game_win.show_maze(m_maze_width, m_maze_height);
+  m_game_win.follow(&core.pacman());
+
+  //add pacman and the ghosts to midground
+  for(Piece* piece : core.actors()) {
+    m_game_win.add(piece, WindowLayer::midground);
+  }
+  //add the maze to background
+  for(Piece* piece : core.maze()) {
+    m_game_win.add(piece, WindowLayer::background);
+  }
+}
+
+int NcursesBackend::get_input(InputMode input_mode)
+{
+  int input = m_scrn.get_ch(input_mode);
+
+  if(input == KEY_RESIZE) {   //lay the windows out for the new terminal and show them again
+    layout();
+    m_game_win.print();
+    m_stat_win.print();
+    m_scrn.update();
+    input = Inputs::NO_INPUT;
+  }
+
+#ifdef PACMAN_PROFILE
+  if(input == Inputs::PROFILE)
+    m_show_profile = !m_show_profile;
+#endif
+
+  return input;
+}
+
+void NcursesBackend::draw_frame(const Game& game)
+{
+  m_game_win.print();
+  print_stats(game);
+  m_scrn.update();    //one terminal update for the whole frame
+}
+
+void NcursesBackend::show_message(const string& text)
+{
+  m_message_win.update_text(text);
+  m_message_win.print();
+  m_scrn.update();
+}
+
+void NcursesBackend::pause(int n_milliseconds)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(n_milliseconds));
+}
+
+void NcursesBackend::layout()
+{
+  using namespace Dimensions;
+
+  //as big as the maze, or the minimum for a small one, but only as big as the terminal has room for
+  int height = std::max(1, std::min(std::max(m_maze_height, GAME_SCR_MIN_H), LINES - STAT_SCR_H));
+  int length = std::max(1, std::min(std::max(m_maze_width, GAME_SCR_MIN_W), COLS));
+
+  bool moved = m_game_win.place(height, length, GAME_SCR_COORD);
+  moved = m_stat_win.place(STAT_SCR_H, STAT_SCR_W, Coord{GAME_SCR_COORD.x + height, GAME_SCR_COORD.y}) || moved;
+  moved = m_message_win.place(MSG_SCR_H, length, MSG_SCR_COORD) || moved;
+
+  if(moved) {
+    //clear what the windows left behind, then send them out whole over the cleared screen
+    werase(stdscr);
+    wnoutrefresh(stdscr);
+    m_game_win.touch();
+    m_stat_win.touch();
+    m_message_win.touch();
+  }
+}
+
+void NcursesBackend::print_stats(const Game& game)
+{
+  const GameCore& core = game.core();
+
+  //turn current stats into stirngs
+  string level = "Level: " + to_string(core.level()) + " \n";                //game level
+  string score = "Score: " + to_string(core.pacman().points()) + " \n";      //points
+  string lives = "Lives: " + to_string(core.pacman().lives()) + " \n";       //pacman lives
+  string tick = "Tick: " + to_string(game.clock().period().count()) + "ms"    //tick period and missed deadlines
+                + " Missed: " + to_string(game.clock().missed()) + " \n";
+  string seed = "Seed: " + to_string(core.seed()) + " \n";                   //rng seed, to replay the game
+
+  string stats = level + score + lives + tick + seed;
+
+#ifdef PACMAN_PROFILE
+  if(m_show_profile)
+    stats = profile_overlay(game.profiler());
+#endif
+
+  //print to stats window
+  m_stat_win.update_text(stats);
+  m_stat_win.print();
+}
+
+#ifdef PACMAN_PROFILE
+string NcursesBackend::profile_overlay(const Profiler& profiler)
+{
+  char line[64];
+  string overlay = "phase      p50 us    p99 us\n";
+
+  for(int phase = 0; phase < PROFILE_PHASES; phase++) {
+    ProfilePhase p = static_cast<ProfilePhase>(phase);
+    std::snprintf(line, sizeof(line), "%-8s %9.1f %9.1f\n", phase_name(p),
+                  profiler.percentile_ns(p, 50) / 1000.0, profiler.percentile_ns(p, 99) / 1000.0);
+    overlay += line;
+  }
+  return overlay;
+}
+#endif
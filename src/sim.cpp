@@ -0,0 +1,406 @@
+#include "game.h"
+#include "backend.h"
+#include "level.h"
+#include "replay.h"
+#include "pool.h"
+#include "rng.h"
+#include "config.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+/*
+ * pacman-sim plays many complete games headless across all cores and reports
+ * the spread of their results.
+ *
+ *   pacman-sim --games 10000 --input random
+ *
+ * Each game gets its own seed and input source, and runs on its own Game with
+ * its own backend on whichever worker picks it up. Every maze in the level pack
+ * is loaded before the first game and shared read only, so workers only touch
+ * the packs lock when a game changes level. A game ends at its
+ * first game over, when its input runs out, or after --max-ticks ticks.
+ */
+
+using std::string;
+using std::vector;
+
+namespace
+{
+  constexpr const char* USAGE {"usage: pacman-sim [--games n] [--threads n] [--seed n] [--max-ticks n]\n"
+                               "                  [--input random|scripted|replay] [--script keys] [--replay file]...\n"
+                               "                  [--level file | --level-text locations shapes | --level-pack manifest]\n"
+                               "  --games n      games to play (default: 1000, or one per replay file)\n"
+                               "  --threads n    worker threads (default: one per core)\n"
+                               "  --seed n       seed of the first game, game i uses seed + i (default: 1)\n"
+                               "  --max-ticks n  stop a game after n ticks (default: 100000)\n"
+                               "  --input kind   where each games input comes from (default: random)\n"
+                               "                   random: a random key about every 4 ticks\n"
+                               "                   scripted: the --script keys over and over\n"
+                               "                   replay: the inputs and seed of a replay file\n"
+                               "  --script keys  w,a,s,d to move and . for no input (default: wwwwaaaassssdddd)\n"
+                               "  --replay file  replay to play, repeat to give several, game i plays file i\n"
+                               "  --level file   play a level compiled by pacman-levelc on every level, not the built in mazes\n"
+                               "  --level-text locations shapes  play a level from its text files on every level\n"
+                               "  --level-pack manifest  play the mazes a manifest lists, one after another\n"};
+
+  constexpr long DEFAULT_GAMES {1000};
+  constexpr long DEFAULT_MAX_TICKS {100000};
+  constexpr const char* DEFAULT_SCRIPT {"wwwwaaaassssdddd"};
+
+  enum class InputKind {random, scripted, replay};
+
+  /******************************* INPUT SOURCES *******************************/
+
+  //the input a game gets on each tick
+  class InputSource
+  {
+    public:
+      virtual ~InputSource() = default;
+      virtual int next(long tick) = 0;      //Inputs::QUIT ends the game
+  };
+
+  //presses a random direction key about one tick in four
+  class RandomInput : public InputSource
+  {
+    public:
+      explicit RandomInput(std::uint64_t seed) : m_rng {~seed} {}   //not the ghosts stream
+
+      int next(long) override
+      {
+        constexpr int KEYS[] {Inputs::UP, Inputs::LEFT, Inputs::DOWN, Inputs::RIGHT};
+        if(m_rng.below(4) != 0)
+          return Inputs::NO_INPUT;
+        return KEYS[m_rng.below(4)];
+      }
+
+    private:
+      Rng m_rng;
+  };
+
+  //plays a string of keys over and over, . is no input
+  class ScriptedInput : public InputSource
+  {
+    public:
+      explicit ScriptedInput(const string& script) : m_script {script} {}
+
+      int next(long tick) override
+      {
+        char key = m_script[tick % m_script.size()];
+        return key == '.' ? Inputs::NO_INPUT : key;
+      }
+
+    private:
+      const string& m_script;
+  };
+
+  //the inputs of a replay, the game ends with the replay
+  class ReplayInput : public InputSource
+  {
+    public:
+      explicit ReplayInput(const Replay& replay) : m_replay {replay} {}
+
+      int next(long tick) override
+      {
+        return tick < m_replay.ticks() ? m_replay.input(tick) : Inputs::QUIT;
+      }
+
+    private:
+      const Replay& m_replay;
+  };
+
+  //a headless backend that starts one game and quits at its game over
+  class SimBackend : public NullBackend
+  {
+    public:
+      explicit SimBackend(InputSource& input) : m_input {input} {}
+
+      int get_input(InputMode input_mode) override
+      {
+        if(input_mode == InputMode::block) {    //the start prompt, then the play again prompt
+          bool started = m_started;
+          m_started = true;
+          return started ? Inputs::QUIT : Inputs::PLAY;
+        }
+        return m_input.next(m_tick);
+      }
+
+      void end_tick(const Game&) override { m_tick++; }
+
+    private:
+      InputSource& m_input;
+      bool m_started {false};
+      long m_tick {0};
+  };
+
+  /********************************** RESULTS **********************************/
+
+  struct GameResult
+  {
+    long score;
+    long level;
+    long ticks;
+    long deaths;
+    bool capped;          //stopped by --max-ticks
+  };
+
+  //per worker totals, padded so workers dont share cache lines
+  struct alignas(64) WorkerTotals
+  {
+    long games {0};
+    long ticks {0};
+  };
+
+  //a compiled level, level text files or a level pack given in place of the built in mazes
+  struct LevelOverride
+  {
+    string compiled;
+    string locations;
+    string shapes;
+    string pack;
+  };
+
+  struct Options
+  {
+    long games {DEFAULT_GAMES};
+    int threads {0};
+    std::uint64_t seed {1};
+    long max_ticks {DEFAULT_MAX_TICKS};
+    InputKind input {InputKind::random};
+    string script {DEFAULT_SCRIPT};
+    vector<string> replay_files;
+    LevelOverride level;
+    bool games_set {false};
+  };
+
+  //play one game to its end
+  GameResult play(const std::shared_ptr<LevelPack>& levels, const Options& options, const vector<Replay>& replays, long index)
+  {
+    GameOptions game_options;
+    game_options.throttle = false;
+    game_options.max_ticks = options.max_ticks;
+    game_options.seed = options.seed + index;
+
+    std::unique_ptr<InputSource> input;
+    switch(options.input) {
+      case InputKind::random:
+        input = std::make_unique<RandomInput>(game_options.seed);
+        break;
+      case InputKind::scripted:
+        input = std::make_unique<ScriptedInput>(options.script);
+        break;
+      case InputKind::replay:
+      {
+        const Replay& replay = replays[index % replays.size()];
+        game_options.seed = replay.seed();
+        input = std::make_unique<ReplayInput>(replay);
+        break;
+      }
+    }
+
+    SimBackend backend {*input};
+    Game game {levels, backend, game_options};
+    game.run();
+
+    int lives = game.core().pacman().lives();
+    return GameResult {game.core().pacman().points(),
+                       game.core().level(),
+                       game.ticks(),
+                       GameConfig::PACMAN_START_LIVES - lives,
+                       lives > 0 && game.ticks() >= options.max_ticks};
+  }
+
+  /******************************* DISTRIBUTIONS *******************************/
+
+  //the value at percentile p of sorted values
+  long percentile(const vector<long>& sorted, double p)
+  {
+    std::size_t rank = static_cast<std::size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[rank];
+  }
+
+  void print_distribution(const string& name, vector<long> values)
+  {
+    std::sort(values.begin(), values.end());
+
+    double sum {0};
+    for(long value : values) {
+      sum += value;
+    }
+
+    std::cout << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << sum / values.size()
+              << std::setw(10) << values.front()
+              << std::setw(10) << percentile(values, 50)
+              << std::setw(10) << percentile(values, 90)
+              << std::setw(10) << percentile(values, 99)
+              << std::setw(10) << values.back() << "\n";
+  }
+
+  void print_report(const Options& options, const vector<GameResult>& results,
+                    const vector<WorkerTotals>& totals, long steals, double seconds)
+  {
+    const char* inputs[] {"random", "scripted", "replay"};
+
+    long ticks {0};
+    long capped {0};
+    vector<long> scores, levels, lengths, deaths;
+    for(const GameResult& result : results) {
+      ticks += result.ticks;
+      capped += result.capped;
+      scores.push_back(result.score);
+      levels.push_back(result.level);
+      lengths.push_back(result.ticks);
+      deaths.push_back(result.deaths);
+    }
+
+    std::cout << "games: " << results.size() << "\n"
+              << "threads: " << totals.size() << "\n"
+              << "input: " << inputs[static_cast<int>(options.input)] << "\n"
+              << "seconds: " << seconds << "\n"
+              << "games per second: " << static_cast<long>(results.size() / seconds) << "\n"
+              << "ticks per second: " << static_cast<long>(ticks / seconds) << "\n"
+              << "games stolen: " << steals << "\n"
+              << "games stopped at max ticks: " << capped << "\n"
+              << "games per thread:";
+    for(const WorkerTotals& worker : totals) {
+      std::cout << " " << worker.games;
+    }
+    std::cout << "\n\n";
+
+    std::cout << std::left << std::setw(8) << "" << std::right
+              << std::setw(12) << "mean" << std::setw(10) << "min" << std::setw(10) << "p50"
+              << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    print_distribution("score", scores);
+    print_distribution("level", levels);
+    print_distribution("ticks", lengths);
+    print_distribution("deaths", deaths);
+  }
+
+  //the built in mazes, unless others were given
+  std::shared_ptr<LevelPack> load(const LevelOverride& level)
+  {
+    if(!level.compiled.empty())
+      return LevelPack::compiled_level(level.compiled);
+    if(!level.locations.empty())
+      return LevelPack::text_level(level.locations, level.shapes);
+    if(!level.pack.empty())
+      return LevelPack::load(level.pack);
+    return LevelPack::built_in();
+  }
+
+  Options parse_options(int argc, char* argv[])
+  {
+    Options options;
+
+    for(int i = 1; i < argc; i++) {
+      string arg {argv[i]};
+      if(arg == "--games" && i + 1 < argc) {
+        options.games = std::stol(argv[++i]);
+        options.games_set = true;
+      } else if(arg == "--threads" && i + 1 < argc) {
+        options.threads = std::stoi(argv[++i]);
+      } else if(arg == "--seed" && i + 1 < argc) {
+        options.seed = std::stoull(argv[++i]);
+      } else if(arg == "--max-ticks" && i + 1 < argc) {
+        options.max_ticks = std::stol(argv[++i]);
+      } else if(arg == "--input" && i + 1 < argc) {
+        string kind {argv[++i]};
+        if(kind == "random")
+          options.input = InputKind::random;
+        else if(kind == "scripted")
+          options.input = InputKind::scripted;
+        else if(kind == "replay")
+          options.input = InputKind::replay;
+        else
+          throw std::invalid_argument{kind};
+      } else if(arg == "--script" && i + 1 < argc) {
+        options.script = argv[++i];
+      } else if(arg == "--replay" && i + 1 < argc) {
+        options.replay_files.push_back(argv[++i]);
+      } else if(arg == "--level" && i + 1 < argc && options.level.locations.empty() && options.level.pack.empty()) {
+        options.level.compiled = argv[++i];
+      } else if(arg == "--level-text" && i + 2 < argc && options.level.compiled.empty() && options.level.pack.empty()) {
+        options.level.locations = argv[++i];
+        options.level.shapes = argv[++i];
+      } else if(arg == "--level-pack" && i + 1 < argc && options.level.compiled.empty() && options.level.locations.empty()) {
+        options.level.pack = argv[++i];
+      } else {
+        throw std::invalid_argument{arg};
+      }
+    }
+
+    if(!options.replay_files.empty())
+      options.input = InputKind::replay;
+    if(options.input == InputKind::replay && options.replay_files.empty())
+      throw std::invalid_argument{"no replay"};
+    if(options.input == InputKind::replay && !options.games_set)
+      options.games = options.replay_files.size();
+
+    if(options.games <= 0 || options.threads < 0 || options.max_ticks <= 0 || options.script.empty())
+      throw std::invalid_argument{"range"};
+    if(options.script.find_first_not_of("wasd.") != string::npos)
+      throw std::invalid_argument{options.script};
+
+    if(options.threads == 0)
+      options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    return options;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+  try {
+    options = parse_options(argc, argv);
+  } catch(const std::logic_error&) {    //bad option or number
+    std::cerr << USAGE;
+    return 2;
+  }
+
+  std::shared_ptr<LevelPack> levels;
+  vector<SharedLevel> mazes;      //every maze held for the whole run, so workers never load one
+  vector<Replay> replays;
+  try {
+    levels = load(options.level);
+    for(int n = 0; n < levels->size(); n++)
+      mazes.push_back(levels->level(GameConfig::STARTING_LEVEL + n));
+
+    for(const string& file : options.replay_files) {
+      replays.push_back(Replay::load(file));
+      if(replays.back().level_checksum() != levels->checksum())
+        throw ReplayError{"'" + file + "' was recorded on a different level"};
+    }
+  } catch(const std::runtime_error& e) {    //LevelError or ReplayError
+    std::cerr << "pacman-sim: " << e.what() << "\n";
+    return 1;
+  }
+
+  vector<GameResult> results(options.games);
+  vector<WorkerTotals> totals(options.threads);
+  WorkPool pool {options.threads};
+
+  auto start = std::chrono::steady_clock::now();
+
+  //each task writes only its own result and its workers totals
+  pool.run(options.games, [&](long index, int worker) {
+    results[index] = play(levels, options, replays, index);
+    totals[worker].games++;
+    totals[worker].ticks += results[index].ticks;
+  });
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  print_report(options, results, totals, pool.steals(), elapsed.count());
+
+  return 0;
+}
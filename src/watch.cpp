@@ -0,0 +1,146 @@
+#include "watch.h"
+#include "level.h"
+#include "pack.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+using std::string;
+using std::vector;
+
+namespace
+{
+  constexpr int STOP_POLL_MS {200};     //how often the watcher checks if it should stop
+  constexpr int SETTLE_MS {50};         //how long to wait for the rest of a save before reloading
+
+  constexpr std::uint32_t EVENTS {IN_CLOSE_WRITE | IN_MOVED_TO};    //a file written, or renamed into place
+}
+
+/******************************** LEVELWATCHER *********************************/
+
+LevelWatcher::LevelWatcher(std::shared_ptr<LevelPack> levels)
+  : m_levels {std::move(levels)}
+{
+  m_inotify = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  if(m_inotify < 0)
+    throw WatchError{string{"can't watch the level files: "} + std::strerror(errno)};
+
+  for(int maze = 0; maze < m_levels->size(); maze++) {
+    for(const string& file : m_levels->files(maze)) {
+      std::size_t slash = file.rfind('/');
+      string directory = slash == string::npos ? "." : file.substr(0, slash + 1);
+
+      //a directory watched twice gets the same watch back
+      int watch = inotify_add_watch(m_inotify, directory.c_str(), EVENTS);
+      if(watch < 0) {
+        string error = std::strerror(errno);
+        close(m_inotify);
+        throw WatchError{"can't watch '" + directory + "': " + error};
+      }
+      m_files.push_back(WatchedFile{watch, file.substr(slash + 1), maze});
+    }
+  }
+
+  if(m_files.empty()) {
+    close(m_inotify);
+    throw WatchError{"the built in levels have no files to watch"};
+  }
+
+  m_thread = std::thread {&LevelWatcher::watch, this};
+}
+
+LevelWatcher::~LevelWatcher()
+{
+  m_stop = true;
+  m_thread.join();
+
+  close(m_inotify);
+
+  for(Node* node = m_reloads.exchange(nullptr); node; ) {
+    Node* next = node->next;
+    delete node;
+    node = next;
+  }
+}
+
+vector<LevelReload> LevelWatcher::take()
+{
+  vector<LevelReload> reloads;
+
+  for(Node* node = m_reloads.exchange(nullptr, std::memory_order_acquire); node; ) {
+    reloads.push_back(std::move(node->reload));
+    Node* next = node->next;
+    delete node;
+    node = next;
+  }
+  return reloads;
+}
+
+void LevelWatcher::watch()
+{
+  vector<bool> changed(m_levels->size());
+  bool pending {false};     //a change is waiting to settle
+
+  while(!m_stop) {
+    pollfd events {m_inotify, POLLIN, 0};
+    if(poll(&events, 1, pending ? SETTLE_MS : STOP_POLL_MS) > 0) {
+      read_events(changed);
+      pending = true;
+      continue;
+    }
+
+    if(!pending)
+      continue;
+
+    //quiet for SETTLE_MS, the saves are done
+    for(int maze = 0; maze < m_levels->size(); maze++) {
+      if(!changed[maze])
+        continue;
+      changed[maze] = false;
+
+      try {
+        push(LevelReload{maze, m_levels->reload(maze), ""});
+      } catch(const LevelError& e) {
+        push(LevelReload{maze, nullptr, e.what()});
+      }
+    }
+    pending = false;
+  }
+}
+
+void LevelWatcher::read_events(vector<bool>& changed)
+{
+  alignas(inotify_event) char buffer[4096];
+
+  ssize_t n;
+  while((n = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+    for(char* at = buffer; at < buffer + n; ) {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+      at += sizeof(inotify_event) + event->len;
+
+      if(event->len == 0)
+        continue;
+      for(const WatchedFile& file : m_files) {
+        if(file.watch == event->wd && file.name == event->name)
+          changed[file.maze] = true;
+      }
+    }
+  }
+}
+
+void LevelWatcher::push(LevelReload reload)
+{
+  Node* node = new Node{std::move(reload), m_reloads.load(std::memory_order_relaxed)};
+  while(!m_reloads.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    continue;
+}